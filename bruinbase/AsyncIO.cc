@@ -0,0 +1,310 @@
+/**
+ * Copyright (C) 2008 by The Regents of the University of California
+ * Redistribution of this file is permitted under the terms of the GNU
+ * Public License (GPL).
+ *
+ * @date 3/24/2008
+ */
+
+#include "AsyncIO.h"
+#include <cerrno>
+#include <cstring>
+#include <stdint.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using std::lock_guard;
+using std::chrono::steady_clock;
+using std::mutex;
+using std::unique_lock;
+
+// the time since a read was started in microseconds
+static long long elapsedUsec(const AsyncRead* req)
+{
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+    steady_clock::now() - req->start).count();
+}
+
+// io_uring has no wrapper in libc, so it is called through syscall(2)
+static int uringSetup(unsigned entries, struct io_uring_params* params)
+{
+  return (int) syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int uringEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags)
+{
+  return (int) syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, NULL, 0);
+}
+
+AsyncIO::AsyncIO(int depth, bool uring)
+{
+  this->depth = (depth < 1) ? 1 : depth;
+  inflight = 0;
+  ringFd = -1;
+  sqRing = cqRing = sqeArray = NULL;
+  sqRingSize = cqRingSize = sqeSize = 0;
+  stopping = false;
+
+  if (uring && setupUring()) return;
+
+  // io_uring is not available. run the reads on a pool of threads.
+  for (int i = 0; i < THREAD_COUNT; i++) {
+    workers.push_back(std::thread(&AsyncIO::runWorker, this));
+  }
+}
+
+AsyncIO::~AsyncIO()
+{
+  // the kernel or the workers may still write to the buffers of
+  // outstanding reads, so wait for all of them
+  while (next(true) != NULL);
+
+  if (ringFd >= 0) {
+    closeUring();
+  } else {
+    {
+      lock_guard<mutex> guard(lock);
+      stopping = true;
+    }
+    workReady.notify_all();
+    for (unsigned i = 0; i < workers.size(); i++) workers[i].join();
+  }
+}
+
+RC AsyncIO::queue(AsyncRead* req)
+{
+  RC rc;
+
+  // keep at most depth reads in flight
+  while (inflight + (int) queued.size() >= depth) {
+    if ((rc = submit()) < 0) return rc;
+    if (ringFd >= 0) reapUring(true); else reapThreads(true);
+  }
+
+  queued.push_back(req);
+  return 0;
+}
+
+void AsyncIO::finish(AsyncRead* req, RC rc)
+{
+  req->rc = rc;
+  req->issued = false;
+  req->usec = 0;
+  done.push_back(req);
+}
+
+RC AsyncIO::submit()
+{
+  if (queued.empty()) return 0;
+
+  steady_clock::time_point now = steady_clock::now();
+  for (unsigned i = 0; i < queued.size(); i++) {
+    queued[i]->issued = true;
+    queued[i]->start = now;
+  }
+  if (ringFd >= 0) return startUring();
+
+  // hand the reads over to the workers
+  {
+    lock_guard<mutex> guard(lock);
+    for (unsigned i = 0; i < queued.size(); i++) work.push_back(queued[i]);
+  }
+  inflight += (int) queued.size();
+  queued.clear();
+  workReady.notify_all();
+
+  return 0;
+}
+
+AsyncRead* AsyncIO::next(bool wait)
+{
+  if (done.empty()) {
+    // a failed submission completes its reads with an error,
+    // so they are returned below like any other read
+    submit();
+    if (ringFd >= 0) reapUring(wait); else reapThreads(wait);
+  }
+
+  if (done.empty()) return NULL;
+
+  AsyncRead* req = done.front();
+  done.pop_front();
+  return req;
+}
+
+bool AsyncIO::setupUring()
+{
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+
+  int fd = uringSetup(depth, &params);
+  if (fd < 0) return false;
+  ringFd = fd;
+
+  // map the two rings and the submission entries into our memory.
+  // newer kernels place both rings in a single mapping.
+  sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single && cqRingSize > sqRingSize) sqRingSize = cqRingSize;
+
+  sqRing = mmap(NULL, sqRingSize, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+  if (sqRing == MAP_FAILED) { sqRing = NULL; closeUring(); return false; }
+
+  if (single) {
+    cqRing = sqRing;
+  } else {
+    cqRing = mmap(NULL, cqRingSize, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    if (cqRing == MAP_FAILED) { cqRing = NULL; closeUring(); return false; }
+  }
+
+  sqeSize = params.sq_entries * sizeof(struct io_uring_sqe);
+  sqeArray = mmap(NULL, sqeSize, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+  if (sqeArray == MAP_FAILED) { sqeArray = NULL; closeUring(); return false; }
+
+  char* sq = (char*) sqRing;
+  sqTail  = (unsigned*) (sq + params.sq_off.tail);
+  sqMask  = (unsigned*) (sq + params.sq_off.ring_mask);
+  sqIndex = (unsigned*) (sq + params.sq_off.array);
+
+  char* cq = (char*) cqRing;
+  cqHead = (unsigned*) (cq + params.cq_off.head);
+  cqTail = (unsigned*) (cq + params.cq_off.tail);
+  cqMask = (unsigned*) (cq + params.cq_off.ring_mask);
+  cqes   = cq + params.cq_off.cqes;
+
+  // the kernel may round the queue size, but never below depth
+  if (depth > (int) params.sq_entries) depth = (int) params.sq_entries;
+
+  return true;
+}
+
+void AsyncIO::closeUring()
+{
+  if (sqeArray != NULL) munmap(sqeArray, sqeSize);
+  if (cqRing != NULL && cqRing != sqRing) munmap(cqRing, cqRingSize);
+  if (sqRing != NULL) munmap(sqRing, sqRingSize);
+  sqRing = cqRing = sqeArray = NULL;
+
+  ::close(ringFd);
+  ringFd = -1;
+}
+
+RC AsyncIO::startUring()
+{
+  // we are the only producer, so the tail can be read without ordering
+  unsigned tail = *sqTail;
+  unsigned mask = *sqMask;
+  struct io_uring_sqe* sqes = (struct io_uring_sqe*) sqeArray;
+
+  for (unsigned i = 0; i < queued.size(); i++) {
+    AsyncRead* req = queued[i];
+    unsigned slot = (tail + i) & mask;
+    struct io_uring_sqe* sqe = &sqes[slot];
+
+    req->iov.iov_base = req->buffer;
+    req->iov.iov_len = req->size;
+
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_READV;
+    sqe->fd = req->fd;
+    sqe->addr = (uint64_t) (uintptr_t) &req->iov;
+    sqe->len = 1;
+    sqe->off = (uint64_t) req->offset;
+    sqe->user_data = (uint64_t) (uintptr_t) req;
+    sqIndex[slot] = slot;
+  }
+
+  // publish the entries before the kernel looks at the new tail
+  unsigned count = (unsigned) queued.size();
+  __atomic_store_n(sqTail, tail + count, __ATOMIC_RELEASE);
+
+  // start all of them with one system call
+  unsigned started = 0;
+  while (started < count) {
+    int n = uringEnter(ringFd, count - started, 0, 0);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) break;
+    started += n;
+  }
+  inflight += started;
+
+  if (started < count) {
+    // take back the entries the kernel did not consume and fail them
+    __atomic_store_n(sqTail, tail + started, __ATOMIC_RELEASE);
+    for (unsigned i = started; i < count; i++) finish(queued[i], RC_FILE_READ_FAILED);
+    queued.clear();
+    return RC_FILE_READ_FAILED;
+  }
+
+  queued.clear();
+  return 0;
+}
+
+void AsyncIO::reapUring(bool wait)
+{
+  struct io_uring_cqe* entries = (struct io_uring_cqe*) cqes;
+
+  for (;;) {
+    unsigned head = *cqHead;
+    unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+
+    // move the completed reads to the done list
+    for (; head != tail; head++) {
+      struct io_uring_cqe* cqe = &entries[head & *cqMask];
+      AsyncRead* req = (AsyncRead*) (uintptr_t) cqe->user_data;
+      req->rc = (cqe->res == (int) req->size) ? 0 : RC_FILE_READ_FAILED;
+      req->usec = elapsedUsec(req);
+      done.push_back(req);
+      inflight--;
+    }
+    __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+
+    if (!wait || !done.empty() || inflight == 0) return;
+
+    // sleep in the kernel until a read completes
+    if (uringEnter(ringFd, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) return;
+  }
+}
+
+void AsyncIO::runWorker()
+{
+  for (;;) {
+    AsyncRead* req;
+    {
+      unique_lock<mutex> guard(lock);
+      while (work.empty() && !stopping) workReady.wait(guard);
+      if (work.empty()) return;
+      req = work.front();
+      work.pop_front();
+    }
+
+    ssize_t n = ::pread(req->fd, req->buffer, req->size, req->offset);
+    req->rc = (n == (ssize_t) req->size) ? 0 : RC_FILE_READ_FAILED;
+    req->usec = elapsedUsec(req);
+
+    {
+      lock_guard<mutex> guard(lock);
+      finished.push_back(req);
+    }
+    workDone.notify_one();
+  }
+}
+
+void AsyncIO::reapThreads(bool wait)
+{
+  unique_lock<mutex> guard(lock);
+
+  while (wait && finished.empty() && inflight > 0) workDone.wait(guard);
+
+  while (!finished.empty()) {
+    done.push_back(finished.front());
+    finished.pop_front();
+    inflight--;
+  }
+}
@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2008 by The Regents of the University of California
+ * Redistribution of this file is permitted under the terms of the GNU
+ * Public License (GPL).
+ *
+ * @date 3/24/2008
+ */
+
+#ifndef ASYNCIO_H
+#define ASYNCIO_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include "Bruinbase.h"
+
+/**
+ * A read handled by AsyncIO.
+ * The request must stay alive until AsyncIO::next() returns it.
+ */
+struct AsyncRead {
+  int    fd;      // the file to read from
+  off_t  offset;  // the file offset to read at
+  size_t size;    // # bytes to read
+  void*  buffer;  // the memory buffer to read into
+  RC     rc;      // the result of the read. set when it completes
+  void*  tag;     // not used by AsyncIO. lets the caller identify the request
+  bool   issued;  // true if the file was read. false if finish() completed it
+  long long usec; // the time from submit() to the completion in microseconds
+  std::chrono::steady_clock::time_point start; // when the read was started
+  struct iovec iov; // used by the io_uring engine
+};
+
+/**
+ * Runs many reads at once without blocking the caller.
+ * Reads are queued with queue(), started with submit(), and collected
+ * with next() in the order they complete.
+ *
+ * Reads are run by io_uring when the kernel supports it. Queued reads
+ * are then started with a single system call. Otherwise a small pool
+ * of threads runs them with pread(2).
+ *
+ * An AsyncIO object must be used by one thread at a time.
+ */
+class AsyncIO {
+ public:
+  static const int DEFAULT_DEPTH = 64;  // default max # of reads in flight
+  static const int THREAD_COUNT = 4;    // # of threads of the fallback engine
+
+  /**
+   * create an engine.
+   * @param depth[IN] the max # of reads in flight at a time
+   * @param uring[IN] false forces the thread-pool engine
+   */
+  AsyncIO(int depth = DEFAULT_DEPTH, bool uring = true);
+
+  /**
+   * wait for all reads in flight, then release the engine.
+   */
+  ~AsyncIO();
+
+  /**
+   * queue a read. when depth reads are already in flight, this
+   * waits until one of them completes. the completed read is
+   * still returned by next() later.
+   * @param req[IN] the read to queue
+   * @return error code. 0 if no error
+   */
+  RC queue(AsyncRead* req);
+
+  /**
+   * complete a request right away without I/O, e.g., because its data
+   * was found in memory. it is returned by next() like any other read.
+   * @param req[IN] the request
+   * @param rc[IN] the result of the request
+   */
+  void finish(AsyncRead* req, RC rc);
+
+  /**
+   * start all queued reads.
+   * @return error code. 0 if no error
+   */
+  RC submit();
+
+  /**
+   * get a completed read. queued reads are started first.
+   * @param wait[IN] if true, wait until a read completes
+   * @return the completed read. NULL if none is completed
+   *   (or, when waiting, if no read is outstanding)
+   */
+  AsyncRead* next(bool wait = true);
+
+  /**
+   * @return # of requests that were queued but not returned by next()
+   */
+  int pending() const { return (int) (inflight + queued.size() + done.size()); }
+
+  /**
+   * @return true if the reads are run by io_uring
+   */
+  bool usesUring() const { return ringFd >= 0; }
+
+ private:
+  int depth;       // the max # of reads in flight
+  int inflight;    // # of reads started but not completed
+  std::vector<AsyncRead*> queued; // reads queued but not started
+  std::deque<AsyncRead*>  done;   // completed reads not yet returned
+
+  // io_uring engine
+  int       ringFd;    // the io_uring file descriptor. -1 if not used
+  void*     sqRing;    // the submission queue ring
+  void*     cqRing;    // the completion queue ring
+  void*     sqeArray;  // the submission queue entries
+  size_t    sqRingSize;
+  size_t    cqRingSize;
+  size_t    sqeSize;
+  unsigned* sqTail;
+  unsigned* sqMask;
+  unsigned* sqIndex;
+  unsigned* cqHead;
+  unsigned* cqTail;
+  unsigned* cqMask;
+  void*     cqes;
+
+  bool setupUring();
+  void closeUring();
+  RC   startUring();
+  void reapUring(bool wait);
+
+  // thread-pool engine
+  std::vector<std::thread> workers;
+  std::mutex               lock;      // protects the two queues below
+  std::condition_variable  workReady; // signaled when work is added
+  std::condition_variable  workDone;  // signaled when a read completes
+  std::deque<AsyncRead*>   work;      // reads waiting for a worker
+  std::deque<AsyncRead*>   finished;  // reads completed by the workers
+  bool                     stopping;  // tells the workers to exit
+
+  void runWorker();
+  void reapThreads(bool wait);
+
+  // the engine is bound to its rings and threads, so it is not copyable
+  AsyncIO(const AsyncIO&);
+  AsyncIO& operator=(const AsyncIO&);
+};
+
+#endif // ASYNCIO_H
@@ -9,6 +9,7 @@
  
 #include "BTreeIndex.h"
 #include "BTreeNode.h"
+#include <vector>
 
 using namespace std;
 
@@ -19,6 +20,7 @@ BTreeIndex::BTreeIndex()
 {
     rootPid = -1;
     treeHeight = 0;
+    leafEnd = 0;
 }
 
 /*
@@ -32,13 +34,23 @@ RC BTreeIndex::open(const string& indexname, char mode)
 {
     if(pf.open(indexname, mode)!=0)
     	return DEFAULT_ERROR_CODE;
+    leafEnd = 0;
     if(pf.endPid()>0) {
-    	char buffer[DEFAULT_SIZE];
-    	pf.read(TREE_PAGE, buffer);
-    	bTreeInfo* info=(bTreeInfo*) buffer;
+    	vector<char> buffer(pf.getPageSize());
+    	pf.read(TREE_PAGE, &buffer[0], PAGE_META);
+    	bTreeInfo* info=(bTreeInfo*) &buffer[0];
     	treeHeight=info->totalHeight;
     	rootPid=info->rootPid;
     }
+    else if(mode=='w' || mode=='W') {
+    	//reserve the tree info page, so that node pages are allocated after it
+    	vector<char> buffer(pf.getPageSize());
+    	bTreeInfo* info=(bTreeInfo*) &buffer[0];
+    	info->totalHeight=0;
+    	info->rootPid=-1;
+    	if(pf.write(TREE_PAGE, &buffer[0], PAGE_META)!=0)
+    		return DEFAULT_ERROR_CODE;
+    }
     return 0;
 
 }
@@ -49,12 +61,12 @@ RC BTreeIndex::open(const string& indexname, char mode)
  */
 RC BTreeIndex::close()
 {
-    char buffer[DEFAULT_SIZE];
-    pf.read(TREE_PAGE, buffer);
-    bTreeInfo* info=(bTreeInfo*) buffer;
+    vector<char> buffer(pf.getPageSize());
+    pf.read(TREE_PAGE, &buffer[0], PAGE_META);
+    bTreeInfo* info=(bTreeInfo*) &buffer[0];
     info->totalHeight=treeHeight;
     info->rootPid=rootPid;
-    pf.write(TREE_PAGE, buffer);
+    pf.write(TREE_PAGE, &buffer[0], PAGE_META);
     return pf.close();
 }
 
@@ -167,9 +179,11 @@ RC BTreeIndex::insert(int key, const RecordId& rid)
 	//if tree is empty
 	if(treeHeight==0) {
 		//make the root a leaf node
-		BTLeafNode lnode;
+		BTLeafNode lnode(pf.getPageSize());
 		lnode.insert(key, rid);
-		rootPid=1;//update rootpid to 1 as 0 holds tree info
+		//page 0 holds tree info, so the root gets a page after it
+		if(pf.allocatePage(rootPid)!=0)
+			return DEFAULT_ERROR_CODE;
 		lnode.write(rootPid, pf);
 		treeHeight=1;//set tree height to 1
 		return 0;
@@ -180,9 +194,10 @@ RC BTreeIndex::insert(int key, const RecordId& rid)
 		PageId npid;
 		//if the root node needs to be split then create a new root non-leaf node
 		if(insertRecursively(key, rid, 1, rootPid, nkey, npid)==RC_NODE_FULL) {
-			BTNonLeafNode node;
+			BTNonLeafNode node(pf.getPageSize());
 			RC rval=node.initializeRoot(rootPid, nkey, npid);
-			rootPid=pf.endPid();
+			if(pf.allocatePage(rootPid)!=0)
+				return DEFAULT_ERROR_CODE;
 			node.write(rootPid, pf);
 			treeHeight++;
 			return rval;
@@ -203,7 +218,7 @@ RC BTreeIndex::insert(int key, const RecordId& rid)
 RC BTreeIndex::insertRecursively(int key, const RecordId& rid, int height, PageId curNodePid, int& nkey, PageId& npid) {
 	//if we are at leaf level
 	if(height==treeHeight) {
-		BTLeafNode leaf;
+		BTLeafNode leaf(pf.getPageSize());
 		leaf.read(curNodePid, pf); //read current node's info
 		//try inserting the key into leaf node
 		if(leaf.insert(key, rid)==0) {
@@ -213,11 +228,13 @@ RC BTreeIndex::insertRecursively(int key, const RecordId& rid, int height, PageI
 			return 0;
 		}
 		//if insertion fails aka splitting is required
-		BTLeafNode sibling;
+		BTLeafNode sibling(pf.getPageSize());
 		int siblingKey;
 		leaf.insertAndSplit(key, rid, sibling, siblingKey);
-		//set sibling pid to be the end pid as it is being newly created
-		PageId siblingPid=pf.endPid();
+		//get a page for the sibling as it is being newly created
+		PageId siblingPid;
+		if(pf.allocatePage(siblingPid)!=0)
+			return DEFAULT_ERROR_CODE;
 		//write the sibling node into memory
 		sibling.write(siblingPid, pf);
 		//set current node's next node pointer to be the sibling node
@@ -231,7 +248,7 @@ RC BTreeIndex::insertRecursively(int key, const RecordId& rid, int height, PageI
 		return RC_NODE_FULL;
 	}
 	//get info of current non-leaf node as we are not at leaf level
-	BTNonLeafNode node;
+	BTNonLeafNode node(pf.getPageSize());
 	node.read(curNodePid, pf);
 	PageId cpid=-1;
 	//get child ptr to insert to
@@ -251,14 +268,16 @@ RC BTreeIndex::insertRecursively(int key, const RecordId& rid, int height, PageI
 		//if insertion fails
 		else {
 			//create sibling node and middle key
-			BTNonLeafNode sibling;
+			BTNonLeafNode sibling(pf.getPageSize());
 			int middleKey=0;
 			//split the node
 			node.insertAndSplit(gkey, gpid, sibling, middleKey);
 			//write the original node to disk
 			node.write(curNodePid, pf);
 			//get new position for sibling node
-			PageId siblingPid=pf.endPid();
+			PageId siblingPid;
+			if(pf.allocatePage(siblingPid)!=0)
+				return DEFAULT_ERROR_CODE;
 			//write sibling node to disk
 			sibling.write(siblingPid, pf);
 			//set pushup key and pid
@@ -294,31 +313,31 @@ RC BTreeIndex::locate(int searchKey, IndexCursor& cursor)
     	return RC_NO_SUCH_RECORD;
     //set pid to root intitially
     PageId pid=rootPid;
-    //create new non-leaf node and intitalize it as the root
-    BTNonLeafNode* node=new BTNonLeafNode();
-    node->initializeRoot(0,-1,-1);
+    //non-leaf node used for the traversal. each read pins the page in pf
+    //and the node looks at it in place, so no level copies its page
+    BTNonLeafNode node(pf.getPageSize());
     //if tree has more than a root node
     if(treeHeight>1) {
     	//reach correct leafnode for searchkey
     	for(int currHeight=1; currHeight<treeHeight; currHeight++) {
     		//read contents of NonLeafNode
-    		if(node->read(pid, pf)<0)
+    		if(node.read(pid, pf)<0)
     			return DEFAULT_ERROR_CODE;
     		//find next node to lead up to correct leaf node, here pid will point us to the right node
-    		if(node->locateChildPtr(searchKey, pid)<0)
+    		if(node.locateChildPtr(searchKey, pid)<0)
     			return DEFAULT_ERROR_CODE;
     	}
     }
     //create a leafe node
-    BTLeafNode* leaf=new BTLeafNode();
-    //read contents of NonLeafNode
-    if(leaf->read(pid, pf)<0)
+    BTLeafNode leaf(pf.getPageSize());
+    //read contents of LeafNode
+    if(leaf.read(pid, pf)<0)
     	return DEFAULT_ERROR_CODE;
+    //the cursor points into this leaf whether or not the key is found
+    cursor.pid=pid;
     //find key in leaf node, if key is found set cursor's eid to eid of the found key
-    if(leaf->locate(searchKey, cursor.eid)<0)
+    if(leaf.locate(searchKey, cursor.eid)<0)
     	return RC_NO_SUCH_RECORD;
-    //if key is found then set the cursor's pid to the pid of the leaf-node
-    cursor.pid=pid;
     return 0;
 }
 /*
@@ -331,12 +350,38 @@ RC BTreeIndex::locate(int searchKey, IndexCursor& cursor)
  */
 RC BTreeIndex::readForward(IndexCursor& cursor, int& key, RecordId& rid)
 {
-    BTLeafNode* leaf=new BTLeafNode();
-    //read contents of NonLeafNode
-    if(leaf->read(cursor.pid, pf)<0)
+    //an empty tree has no entries to read
+    if(treeHeight==0)
+    	return RC_END_OF_TREE;
+    BTLeafNode leaf(pf.getPageSize());
+    //read contents of LeafNode
+    if(leaf.read(cursor.pid, pf)<0)
     	return DEFAULT_ERROR_CODE;
+    //past the end of the leaf, move on to the next leaf in the chain.
+    //page 0 holds the tree info, so a next pointer of 0 ends the chain
+    while(cursor.eid>=leaf.getKeyCount()) {
+    	PageId next=leaf.getNextNodePtr();
+    	if(next<=0)
+    		return RC_END_OF_TREE;
+    	//adjacent leaves are read together ahead of the walk
+    	if(next==cursor.pid+1 && next>=leafEnd) {
+    		int n=pf.endPid()-next;
+    		if(n>LEAF_WINDOW)
+    			n=LEAF_WINDOW;
+    		vector<char> window((size_t) n*pf.getPageSize());
+    		vector<char*> buffers(n);
+    		for(int i=0; i<n; i++)
+    			buffers[i]=&window[(size_t) i*pf.getPageSize()];
+    		if(n>0 && pf.readRange(next, n, &buffers[0], PAGE_LEAF)==0)
+    			leafEnd=next+n;
+    	}
+    	cursor.pid=next;
+    	cursor.eid=0;
+    	if(leaf.read(cursor.pid, pf)<0)
+    		return DEFAULT_ERROR_CODE;
+    }
     //get contents of cursor eid
-    if(leaf->readEntry(cursor.eid, key, rid)<0)
+    if(leaf.readEntry(cursor.eid, key, rid)<0)
     	return DEFAULT_ERROR_CODE;
     //move forward cursor by incrementing cursor.eid
     cursor.eid++;
@@ -359,13 +404,13 @@ void BTreeIndex::printRecurse(PageId pid, int level)
 	// Leaf node
 	else if (level == treeHeight)
 	{
-		BTLeafNode node;
+		BTLeafNode node(pf.getPageSize());
 		node.read(pid, pf);
 		node.print();
 	}
 	else
 	{
-		BTNonLeafNode node;
+		BTNonLeafNode node(pf.getPageSize());
 		
 		node.read(pid, pf);
 		node.print();
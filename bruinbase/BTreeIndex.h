@@ -34,6 +34,8 @@ typedef struct {
 #define TREE_PAGE 0
 #define DEFAULT_ERROR_CODE -1
 #define DEFAULT_SIZE 1024
+//max # of adjacent leaves readForward() reads at once
+#define LEAF_WINDOW 16
 /**
  * Implements a B-Tree index for bruinbase.
  * 
@@ -46,8 +48,9 @@ class BTreeIndex {
   /**
    * Open the index file in read or write mode.
    * Under 'w' mode, the index file should be created if it does not exist.
+   * Under 'm' mode, the index file is read-only and memory-mapped.
    * @param indexname[IN] the name of the index file
-   * @param mode[IN] 'r' for read, 'w' for write
+   * @param mode[IN] 'r' for read, 'w' for write, 'm' for mapped read
    * @return error code. 0 if no error
    */
   RC open(const std::string& indexname, char mode);
@@ -92,10 +95,15 @@ class BTreeIndex {
   /**
    * Read the (key, rid) pair at the location specified by the index cursor,
    * and move foward the cursor to the next entry.
+   * When the cursor is past the last entry of its leaf node, the leaf
+   * chain is followed to the first entry of the next leaf.
+   * When the next leaf is also the next page, as after a load in key
+   * order, up to LEAF_WINDOW pages from it on are read with a single
+   * PageFile::readRange() into the buffer pool.
    * @param cursor[IN/OUT] the cursor pointing to an leaf-node index entry in the b+tree
    * @param key[OUT] the key stored at the index cursor location
    * @param rid[OUT] the RecordId stored at the index cursor location
-   * @return error code. 0 if no error
+   * @return error code. RC_END_OF_TREE after the last entry of the tree
    */
   RC readForward(IndexCursor& cursor, int& key, RecordId& rid);
   
@@ -104,6 +112,7 @@ class BTreeIndex {
 
   PageId   rootPid;    /// the PageId of the root node
   int      treeHeight; /// the height of the tree
+  PageId   leafEnd;    /// the end of the pages readForward() read ahead
   /// Note that the content of the above two variables will be gone when
   /// this class is destructed. Make sure to store the values of the two 
   /// variables in disk, so that they can be reconstructed when the index
@@ -4,16 +4,41 @@
 #include <string>
 #include <stdio.h>
 using namespace std;
+//the content of nodes that have no page yet. large enough for any page
+//size plus the spare entry of a non-leaf node. it is never written
+static char zeroPage[PageFile::MAX_PAGE_SIZE+64];
 //leaf node constructor
-BTLeafNode::BTLeafNode() {
-	memset(buffer, 0, PageFile::PAGE_SIZE);
-	maxKeyCount=(PageFile::PAGE_SIZE-sizeof(PageId))/sizeof(entry);
+BTLeafNode::BTLeafNode(int pageSize) {
+	this->pageSize=pageSize;
+	store=NULL;
+	buffer=zeroPage;
+	pinnedFile=NULL;
+	pinnedPid=0;
+	maxKeyCount=(pageSize-sizeof(PageId))/sizeof(entry);
 	currKeyCount=0;
 }
 //leaf node destructor
-// BTLeafNode::~BTLeafNode() {
-// 	delete[] buffer;
-// }
+BTLeafNode::~BTLeafNode() {
+	release();
+	delete [] store;
+}
+//unpin the page the node was read from and go back to the local store
+void BTLeafNode::release() {
+	if(pinnedFile) {
+		pinnedFile->unpin(pinnedPid);
+		pinnedFile=NULL;
+	}
+	buffer=store?store:zeroPage;
+}
+//copy the node content to the local store so the node can be modified
+void BTLeafNode::detach() {
+	if(buffer!=store) {
+		if(!store)
+			store=new char[pageSize];
+		memcpy(store, buffer, pageSize);
+		release();
+	}
+}
 //get method for maxKeyCount
 int BTLeafNode::getMaxKeyCount() {
 	return maxKeyCount;
@@ -26,7 +51,16 @@ int BTLeafNode::getMaxKeyCount() {
  */
 RC BTLeafNode::read(PageId pid, const PageFile& pf)
 {
-	return pf.read(pid, buffer);
+	const char* page;
+	release();
+	//pin the page and work on it in place instead of copying it
+	RC rc=pf.pin(pid, page, PAGE_LEAF);
+	if(rc<0)
+		return rc;
+	buffer=const_cast<char*>(page);
+	pinnedFile=&pf;
+	pinnedPid=pid;
+	return 0;
 }
     
 /*
@@ -37,7 +71,7 @@ RC BTLeafNode::read(PageId pid, const PageFile& pf)
  */
 RC BTLeafNode::write(PageId pid, PageFile& pf)
 {
-	return pf.write(pid, buffer);
+	return pf.write(pid, buffer, PAGE_LEAF);
 }
 
 /*
@@ -59,6 +93,7 @@ int BTLeafNode::getKeyCount()
  */
 RC BTLeafNode::insert(int key, const RecordId& rid)
 {
+	detach();
 	//check if key count is greater than equal to max
 	if(getKeyCount()>=getMaxKeyCount())
 		return RC_NODE_FULL;
@@ -88,6 +123,7 @@ RC BTLeafNode::insert(int key, const RecordId& rid)
 RC BTLeafNode::insertAndSplit(int key, const RecordId& rid, 
                               BTLeafNode& sibling, int& siblingKey)
 {
+	detach();
 	if(sibling.getKeyCount()>0)
 		return -1;
 	int split=(getKeyCount()+1)/2;
@@ -126,7 +162,8 @@ RC BTLeafNode::insertAndSplit(int key, const RecordId& rid,
 RC BTLeafNode::locate(int searchKey, int& eid)
 {
 	entry* tmp=(entry*)buffer; //set pointer to starting entry
-	for(int i=0;i<getKeyCount();i++) {
+	int keyCount=getKeyCount(); //count once, the scan is linear in the page size
+	for(int i=0;i<keyCount;i++) {
 		if(tmp->key==searchKey) { //if searchkey is the key of an entry
 			eid=i;
 			return 0;
@@ -137,7 +174,7 @@ RC BTLeafNode::locate(int searchKey, int& eid)
 		}
 		tmp++;
 	}
-	eid=getKeyCount();//reached end of node without reaching searchKey smaller than existing key or the key itself
+	eid=keyCount;//reached end of node without reaching searchKey smaller than existing key or the key itself
 	return RC_NO_SUCH_RECORD;
 }
 
@@ -183,6 +220,7 @@ PageId BTLeafNode::getNextNodePtr()
  */
 RC BTLeafNode::setNextNodePtr(PageId pid)
 {
+	detach();
 	if(pid<0) //check invalid pid
 		return RC_INVALID_PID;
 	PageId* next=(PageId*)(buffer+getMaxKeyCount()*sizeof(entry)); //find next node similarly to get next node
@@ -201,15 +239,38 @@ RC BTLeafNode::setNextNodePtr(PageId pid)
 //NON-leaf node stuff
 ////////////////////////////////////////////////////////////////////////////////
 //non-leaf node constructor
-BTNonLeafNode::BTNonLeafNode() {
-	memset(buffer, 0, PageFile::PAGE_SIZE);
-	maxKeyCount=(PageFile::PAGE_SIZE-sizeof(PageId))/sizeof(entry);
+BTNonLeafNode::BTNonLeafNode(int pageSize) {
+	this->pageSize=pageSize;
+	store=NULL;
+	buffer=zeroPage;
+	pinnedFile=NULL;
+	pinnedPid=0;
+	maxKeyCount=(pageSize-sizeof(PageId))/sizeof(entry);
 	currKeyCount=0;
 }
-//leaf node destructor
-// BTNonLeafNode::~BTNonLeafNode() {
-// 	delete[] buffer;
-// }
+//non-leaf node destructor
+BTNonLeafNode::~BTNonLeafNode() {
+	release();
+	delete [] store;
+}
+//unpin the page the node was read from and go back to the local store
+void BTNonLeafNode::release() {
+	if(pinnedFile) {
+		pinnedFile->unpin(pinnedPid);
+		pinnedFile=NULL;
+	}
+	buffer=store?store:zeroPage;
+}
+//copy the node content to the local store so the node can be modified
+void BTNonLeafNode::detach() {
+	if(buffer!=store) {
+		if(!store)
+			store=new char[pageSize+sizeof(entry)];
+		memcpy(store, buffer, pageSize);
+		memset(store+pageSize, 0, sizeof(entry));
+		release();
+	}
+}
 //get method for maxKeyCount
 int BTNonLeafNode::getMaxKeyCount() {
 	return maxKeyCount;
@@ -224,7 +285,16 @@ int BTNonLeafNode::getMaxKeyCount() {
  */
 RC BTNonLeafNode::read(PageId pid, const PageFile& pf)
 {
-	return pf.read(pid, buffer);
+	const char* page;
+	release();
+	//pin the page and work on it in place instead of copying it
+	RC rc=pf.pin(pid, page, PAGE_INTERNAL);
+	if(rc<0)
+		return rc;
+	buffer=const_cast<char*>(page);
+	pinnedFile=&pf;
+	pinnedPid=pid;
+	return 0;
 }
     
 /*
@@ -235,7 +305,7 @@ RC BTNonLeafNode::read(PageId pid, const PageFile& pf)
  */
 RC BTNonLeafNode::write(PageId pid, PageFile& pf)
 {
-	return pf.write(pid, buffer);
+	return pf.write(pid, buffer, PAGE_INTERNAL);
 }
 
 /*
@@ -264,15 +334,17 @@ RC BTNonLeafNode::insert(int key, PageId pid)
 	return insertNoSizeCheck(key, pid);
 }
 RC BTNonLeafNode::insertNoSizeCheck(int key, PageId pid) {
+	detach();
 	entry* tmp=(entry*)(buffer+sizeof(PageId));//find first entry
 	if(getKeyCount()==0) {
 		tmp->key=key;
 		tmp->pid=pid;
 		return 0;
 	}
-	for(int i=0;i<getKeyCount();i++) {
+	int keyCount=getKeyCount();
+	for(int i=0;i<keyCount;i++) {
 		if((tmp+i)->key>key) { //if key is between two entrys then move over all the entries on its right and insert in the middle
-			memmove((tmp+i)+1, (tmp+i), (getKeyCount()-i)*sizeof(entry));
+			memmove((tmp+i)+1, (tmp+i), (keyCount-i)*sizeof(entry));
 			(tmp+i)->key=key;
 			(tmp+i)->pid=pid;
 			return 0;
@@ -280,7 +352,7 @@ RC BTNonLeafNode::insertNoSizeCheck(int key, PageId pid) {
 	}
 	//if entry is inserted at the end
 	tmp=(entry*)(buffer+sizeof(PageId));
-	tmp+=getKeyCount();
+	tmp+=keyCount;
 	tmp->key=key;
 	tmp->pid=pid;
 	return 0;
@@ -297,13 +369,15 @@ RC BTNonLeafNode::insertNoSizeCheck(int key, PageId pid) {
  */
 RC BTNonLeafNode::insertAndSplit(int key, PageId pid, BTNonLeafNode& sibling, int& midKey)
 {
-	int split=(getKeyCount()+1)/2;
+	detach();
+	//the node holds one entry more than it can keep until the split is done.
+	//the extra entry lives in the spare room at the end of store
+	int localKeyCount=getKeyCount()+1;
+	int split=localKeyCount/2;
 	insertNoSizeCheck(key, pid);
 	entry* first=(entry*)(buffer+sizeof(PageId));
 	entry* mid=first+split;
-	entry* last=first+getKeyCount();
 	midKey=mid->key;
-	int localKeyCount=getKeyCount();
 	sibling.initializeRoot(mid->pid, (mid+1)->key, (mid+1)->pid);
 	mid->key=0;
 	mid->pid=0;
@@ -331,13 +405,14 @@ RC BTNonLeafNode::locateChildPtr(int searchKey, PageId& pid)
 		pid=*p;
 		return 0;
 	}
-	for(int i=1;i<getKeyCount();i++) {
+	int keyCount=getKeyCount();
+	for(int i=1;i<keyCount;i++) {
 		if((tmp+i)->key>searchKey) { //if searchkey is less than a key then return the pid before that entry
 			pid=(tmp+i-1)->pid;
 			return 0;
 		}
 	}
-	pid=(tmp+getKeyCount()-1)->pid;//if searchkey is greater than all keys then return last pid
+	pid=(tmp+keyCount-1)->pid;//if searchkey is greater than all keys then return last pid
 	return 0;
 }
 
@@ -350,8 +425,9 @@ RC BTNonLeafNode::locateChildPtr(int searchKey, PageId& pid)
  */
 RC BTNonLeafNode::initializeRoot(PageId pid1, int key, PageId pid2)
 {
+	detach();
 	int offset=sizeof(PageId);//get space for first pid
-	memset(buffer, 0, PageFile::PAGE_SIZE);//reset buffer
+	memset(buffer, 0, pageSize);//reset buffer
 	PageId* firstPid=(PageId*) buffer;//the first pid will be at the start of the buffer
 	*firstPid=pid1;//set the first pid 
 	entry* tmp=(entry*)(buffer+offset); //create an entry after the first pid
@@ -22,8 +22,12 @@
  */
 class BTLeafNode {
   public:
-    BTLeafNode();
-    //~BTLeafNode();
+   /**
+    * Create an empty leaf node.
+    * @param pageSize[IN] the page size of the PageFile the node is stored in
+    */
+    BTLeafNode(int pageSize = PageFile::PAGE_SIZE);
+    ~BTLeafNode();
     int getMaxKeyCount();
     void setCurrKeyCount(int x);
     void print();
@@ -93,6 +97,8 @@ class BTLeafNode {
  
    /**
     * Read the content of the node from the page pid in the PageFile pf.
+    * The page stays pinned in pf until the node reads another page,
+    * is modified, or is destroyed.
     * @param pid[IN] the PageId to read
     * @param pf[IN] PageFile to read from
     * @return 0 if successful. Return an error code if there is an error.
@@ -109,10 +115,33 @@ class BTLeafNode {
 
   private:
    /**
-    * The main memory buffer for loading the content of the disk page 
-    * that contains the node.
+    * The main memory buffer for the content of the node when it is
+    * built or modified in memory. It is allocated on the first
+    * modification, so nodes that are only read never allocate it.
     */
-    char buffer[PageFile::PAGE_SIZE];
+    char* store;
+
+   /**
+    * The content of the node. After read(), it points to the disk page
+    * pinned in the PageFile, so that lookups do not copy the page.
+    * Before the node is modified, the page is copied to store.
+    * A node that has neither read nor modified a page points to
+    * a shared page of zeros.
+    */
+    char* buffer;
+    const PageFile* pinnedFile; // the file of the pinned page. NULL if not pinned
+    PageId pinnedPid;           // the pinned page
+
+    // unpin the page (if pinned) and point buffer back to store
+    void release();
+    // make the node content modifiable by copying it to store
+    void detach();
+
+    int pageSize;
+
+    // nodes may hold a pin, so they are not copyable
+    BTLeafNode(const BTLeafNode&);
+    BTLeafNode& operator=(const BTLeafNode&);
 
     int maxKeyCount;
     int currKeyCount;
@@ -128,8 +157,12 @@ class BTLeafNode {
  */
 class BTNonLeafNode {
   public:
-    BTNonLeafNode();
-    //~BTNonLeafNode();
+   /**
+    * Create an empty non-leaf node.
+    * @param pageSize[IN] the page size of the PageFile the node is stored in
+    */
+    BTNonLeafNode(int pageSize = PageFile::PAGE_SIZE);
+    ~BTNonLeafNode();
     int getMaxKeyCount();
     void setCurrKeyCount(int x);
     void print();
@@ -185,6 +218,8 @@ class BTNonLeafNode {
 
    /**
     * Read the content of the node from the page pid in the PageFile pf.
+    * The page stays pinned in pf until the node reads another page,
+    * is modified, or is destroyed.
     * @param pid[IN] the PageId to read
     * @param pf[IN] PageFile to read from
     * @return 0 if successful. Return an error code if there is an error.
@@ -200,18 +235,43 @@ class BTNonLeafNode {
     RC write(PageId pid, PageFile& pf);
 
   private:
+    typedef struct{
+        int key;
+        PageId pid;
+    } entry;
+
+   /**
+    * The main memory buffer for the content of the node when it is
+    * built or modified in memory. It has room for one entry more than
+    * a page, because insertAndSplit() overfills the node before splitting.
+    * It is allocated on the first modification.
+    */
+    char* store;
+
    /**
-    * The main memory buffer for loading the content of the disk page 
-    * that contains the node.
+    * The content of the node. After read(), it points to the disk page
+    * pinned in the PageFile, so that lookups do not copy the page.
+    * Before the node is modified, the page is copied to store.
+    * A node that has neither read nor modified a page points to
+    * a shared page of zeros.
     */
-    char buffer[PageFile::PAGE_SIZE];
+    char* buffer;
+    const PageFile* pinnedFile; // the file of the pinned page. NULL if not pinned
+    PageId pinnedPid;           // the pinned page
+
+    // unpin the page (if pinned) and point buffer back to store
+    void release();
+    // make the node content modifiable by copying it to store
+    void detach();
+
+    int pageSize;
+
+    // nodes may hold a pin, so they are not copyable
+    BTNonLeafNode(const BTNonLeafNode&);
+    BTNonLeafNode& operator=(const BTNonLeafNode&);
 
     int maxKeyCount;
     int currKeyCount;
-    typedef struct{
-        int key;
-        PageId pid;
-    } entry;
 }; 
 
 #endif /* BTREENODE_H */
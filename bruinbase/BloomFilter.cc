@@ -0,0 +1,156 @@
+/**
+ * Copyright (C) 2008 by The Regents of the University of California
+ * Redistribution of this file is permitted under the terms of the GNU
+ * Public License (GPL).
+ *
+ * @date 3/24/2008
+ */
+
+#include "BloomFilter.h"
+#include <cstring>
+#include <unistd.h>
+
+using std::vector;
+
+static const int WORDS = BloomFilter::BLOCK_BITS / 64;  // the 64-bit words of a block
+
+// spread the bits of a key over all 64 bits of the hash
+static uint64_t hashKey(int key)
+{
+  uint64_t h = (uint32_t) key;
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+// find the block of a hash in a level of the given size and the bits
+// the hash sets in each word of the block. the high half of the hash
+// picks the block, and the low half the bits
+static size_t probe(uint64_t h, int blocks, uint64_t mask[WORDS])
+{
+  memset(mask, 0, sizeof(uint64_t) * WORDS);
+  uint32_t g = (uint32_t) h;
+  uint32_t step = (g >> 16) | 1;  // odd, so the bits are distinct
+  for (int i = 0; i < BloomFilter::HASH_COUNT; i++) {
+    int bit = (g + i * step) & (BloomFilter::BLOCK_BITS - 1);
+    mask[bit >> 6] |= (uint64_t) 1 << (bit & 63);
+  }
+  return (size_t) (((h >> 32) * (uint64_t) blocks) >> 32) * WORDS;
+}
+
+// the keys a level of the given size is meant to hold
+static int capacityOf(int blocks)
+{
+  return blocks * (BloomFilter::BLOCK_BITS / BloomFilter::BITS_PER_KEY);
+}
+
+static bool readAll(int fd, void* buffer, size_t size)
+{
+  char* p = (char*) buffer;
+  while (size > 0) {
+    ssize_t n = ::read(fd, p, size);
+    if (n <= 0) return false;
+    p += n;
+    size -= n;
+  }
+  return true;
+}
+
+static bool writeAll(int fd, const void* buffer, size_t size)
+{
+  const char* p = (const char*) buffer;
+  while (size > 0) {
+    ssize_t n = ::write(fd, p, size);
+    if (n <= 0) return false;
+    p += n;
+    size -= n;
+  }
+  return true;
+}
+
+BloomFilter::BloomFilter()
+{
+}
+
+void BloomFilter::clear()
+{
+  levels.clear();
+}
+
+void BloomFilter::add(int key)
+{
+  // start a larger level once the last one is full
+  if (levels.empty() || levels.back().keys >= capacityOf(levels.back().blocks)) {
+    Level level;
+    int capacity = levels.empty() ? FIRST_CAPACITY : GROWTH * capacityOf(levels.back().blocks);
+    level.keys = 0;
+    level.blocks = capacity / (BLOCK_BITS / BITS_PER_KEY);
+    level.bits.assign((size_t) level.blocks * WORDS, 0);
+    levels.push_back(level);
+  }
+
+  Level& level = levels.back();
+  uint64_t mask[WORDS];
+  size_t first = probe(hashKey(key), level.blocks, mask);
+  for (int w = 0; w < WORDS; w++) level.bits[first + w] |= mask[w];
+  level.keys++;
+}
+
+bool BloomFilter::mayContain(int key) const
+{
+  uint64_t h = hashKey(key);
+  for (unsigned i = 0; i < levels.size(); i++) {
+    const Level& level = levels[i];
+    uint64_t mask[WORDS];
+    size_t first = probe(h, level.blocks, mask);
+    int w = 0;
+    while (w < WORDS && (level.bits[first + w] & mask[w]) == mask[w]) w++;
+    if (w == WORDS) return true;
+  }
+  return false;
+}
+
+RC BloomFilter::read(int fd)
+{
+  int count;
+  levels.clear();
+
+  // the number of levels, followed by the size and the bits of each
+  if (!readAll(fd, &count, sizeof(count)) || count < 0) return RC_FILE_READ_FAILED;
+  levels.resize(count);
+  for (int i = 0; i < count; i++) {
+    Level& level = levels[i];
+    if (!readAll(fd, &level.keys, sizeof(level.keys)) ||
+        !readAll(fd, &level.blocks, sizeof(level.blocks)) ||
+        level.keys < 0 || level.blocks <= 0 ||
+        level.blocks != (i == 0 ? FIRST_CAPACITY : GROWTH * capacityOf(levels[i - 1].blocks))
+                        / (BLOCK_BITS / BITS_PER_KEY)) {
+      levels.clear();
+      return RC_FILE_READ_FAILED;
+    }
+    level.bits.resize((size_t) level.blocks * WORDS);
+    if (!readAll(fd, &level.bits[0], sizeof(uint64_t) * level.bits.size())) {
+      levels.clear();
+      return RC_FILE_READ_FAILED;
+    }
+  }
+  return 0;
+}
+
+RC BloomFilter::write(int fd) const
+{
+  int count = (int) levels.size();
+  if (!writeAll(fd, &count, sizeof(count))) return RC_FILE_WRITE_FAILED;
+  for (int i = 0; i < count; i++) {
+    const Level& level = levels[i];
+    if (!writeAll(fd, &level.keys, sizeof(level.keys)) ||
+        !writeAll(fd, &level.blocks, sizeof(level.blocks)) ||
+        !writeAll(fd, &level.bits[0], sizeof(uint64_t) * level.bits.size())) {
+      return RC_FILE_WRITE_FAILED;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2008 by The Regents of the University of California
+ * Redistribution of this file is permitted under the terms of the GNU
+ * Public License (GPL).
+ *
+ * @date 3/24/2008
+ */
+
+#ifndef BLOOMFILTER_H
+#define BLOOMFILTER_H
+
+#include <stdint.h>
+#include <vector>
+#include "Bruinbase.h"
+
+/**
+ * A blocked bloom filter over integer keys.
+ * A key is hashed to one block of 64 bytes, a cache line, and sets
+ * HASH_COUNT bits in it, so a lookup touches one cache line per level.
+ * A key that was added is always found. A key that was not added is
+ * found by a full level with a probability of about 0.2% (a false
+ * positive).
+ *
+ * The filter grows with the keys added to it. It is a series of levels.
+ * When the last level holds as many keys as it was sized for, a new
+ * level GROWTH times as large is started. A lookup checks every level,
+ * so the false positives of the levels add up, to about 1% for a
+ * million keys in 5 levels.
+ */
+class BloomFilter {
+ public:
+  static const int BLOCK_BITS = 512;      // the bits of a block
+  static const int BITS_PER_KEY = 16;     // the bits of a level per key it holds
+  static const int HASH_COUNT = 8;        // the bits a key sets in its block
+  static const int FIRST_CAPACITY = 4096; // the keys of the first level
+  static const int GROWTH = 4;            // the size of a level over the one before
+
+  BloomFilter();
+
+  /**
+   * remove all keys.
+   */
+  void clear();
+
+  /**
+   * add a key to the filter.
+   * @param key[IN] the key to add
+   */
+  void add(int key);
+
+  /**
+   * check whether a key may have been added.
+   * @param key[IN] the key to look up
+   * @return false if the key was never added. true if it was added,
+   *   or, rarely, if it was not
+   */
+  bool mayContain(int key) const;
+
+  /**
+   * read the filter from a file, at its current position.
+   * @param fd[IN] the file descriptor
+   * @return error code. RC_FILE_READ_FAILED if the data is short or corrupt
+   */
+  RC read(int fd);
+
+  /**
+   * write the filter to a file, at its current position.
+   * @param fd[IN] the file descriptor
+   * @return error code. 0 if no error
+   */
+  RC write(int fd) const;
+
+ private:
+  typedef struct {
+    int keys;    // # keys added to the level
+    int blocks;  // # blocks of the level
+    std::vector<uint64_t> bits;  // the blocks, BLOCK_BITS / 64 words each
+  } Level;
+
+  std::vector<Level> levels;  // the last level takes the new keys
+};
+
+#endif // BLOOMFILTER_H
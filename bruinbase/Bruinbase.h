@@ -26,5 +26,9 @@ const int RC_INVALID_CURSOR      = -1011;
 const int RC_NO_SUCH_RECORD      = -1012;
 const int RC_END_OF_TREE         = -1013;
 const int RC_INVALID_ATTRIBUTE   = -1014;
+const int RC_CACHE_IN_USE        = -1015;
+const int RC_CACHE_FULL          = -1016;
+const int RC_INVALID_PAGE_SIZE   = -1017;
+const int RC_END_OF_FILE         = -1019;
 
 #endif // BRUINBASE_H
@@ -0,0 +1,537 @@
+/**
+ * Copyright (C) 2008 by The Regents of the University of California
+ * Redistribution of this file is permitted under the terms of the GNU
+ * Public License (GPL).
+ *
+ * @date 3/24/2008
+ */
+
+#include "BufferPool.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <utility>
+#include <stdint.h>
+
+using std::vector;
+using std::lock_guard;
+using std::mutex;
+using std::unique_lock;
+
+BufferPool::BufferPool(size_t size, int pageSize)
+{
+  int count = (int) (size / pageSize);
+  if (count < 1) count = 1;
+  this->pageSize = pageSize;
+
+  // the frames are carved out of one allocation. the memory is not
+  // touched here, so the OS only commits the frames that get used.
+  // every frame is aligned to the page size (and the first to
+  // FRAME_ALIGNMENT), so it can be written with O_DIRECT.
+  void* addr = NULL;
+  if (posix_memalign(&addr, FRAME_ALIGNMENT, (size_t) count * pageSize) != 0) {
+    throw std::bad_alloc();
+  }
+  memory = (char*) addr;
+
+  frames.resize(count);
+  for (int i = 0; i < count; i++) {
+    frames[i].file = NULL;
+    frames[i].pid = 0;
+    frames[i].kind = PAGE_RECORD;
+    frames[i].queue = FREE;
+    frames[i].referenced = false;
+    frames[i].dirty = false;
+    frames[i].lsn = 0;
+    frames[i].pinCount = 0;
+    frames[i].next = -1;
+    frames[i].fifoPrev = -1;
+    frames[i].fifoNext = -1;
+    frames[i].data = memory + (size_t) i * pageSize;
+  }
+
+  // keep at least 16 frames in a stripe, so that a few pinned pages
+  // cannot exhaust a stripe
+  int nstripes = STRIPE_COUNT;
+  while (nstripes > 1 && count / nstripes < 16) nstripes >>= 1;
+
+  // split the frames evenly among the stripes
+  for (int i = 0; i < nstripes; i++) {
+    Stripe* s = new Stripe;
+    s->first = (int) ((long long) count * i / nstripes);
+    s->count = (int) ((long long) count * (i + 1) / nstripes) - s->first;
+    s->hand = 0;
+
+    // use a power-of-two number of buckets, about one per frame
+    int nbuckets = 1;
+    while (nbuckets < s->count) nbuckets <<= 1;
+    s->buckets.assign(nbuckets, -1);
+
+    // all frames start on the free list
+    for (int f = s->first; f < s->first + s->count; f++) {
+      frames[f].next = (f + 1 < s->first + s->count) ? f + 1 : -1;
+    }
+    s->freeList = s->first;
+
+    // the usual 2Q settings: A1in keeps a quarter of the frames
+    // and A1out remembers as many pages as half of the frames
+    s->inHead = s->inTail = -1;
+    s->inCount = 0;
+    s->inLimit = (s->count + 3) / 4;
+    s->mainCount = 0;
+    s->ghosts.assign((s->count + 1) / 2, 0);
+    s->ghostNext = 0;
+    s->ghostCount = 0;
+
+    stripes.push_back(s);
+  }
+}
+
+BufferPool::~BufferPool()
+{
+  for (unsigned i = 0; i < stripes.size(); i++) delete stripes[i];
+  free(memory);
+}
+
+size_t BufferPool::hash(const PageFile* file, PageId pid) const
+{
+  uint64_t h = (uint64_t) (uintptr_t) file;
+  h ^= (uint64_t) (unsigned) pid * 0x9E3779B97F4A7C15ULL;
+  h ^= h >> 29;
+  return (size_t) h;
+}
+
+int BufferPool::lookup(Stripe& s, size_t h, const PageFile* file, PageId pid)
+{
+  for (int i = s.buckets[bucketOf(s, h)]; i >= 0; i = frames[i].next) {
+    if (frames[i].file == file && frames[i].pid == pid) return i;
+  }
+  return -1;
+}
+
+void BufferPool::unlink(Stripe& s, int frame)
+{
+  Frame& f = frames[frame];
+  size_t h = hash(f.file, f.pid);
+  int* link = &s.buckets[bucketOf(s, h)];
+
+  // walk down the bucket chain and cut the frame out of it
+  while (*link >= 0) {
+    if (*link == frame) {
+      *link = f.next;
+      break;
+    }
+    link = &frames[*link].next;
+  }
+
+  // take the frame out of its queue
+  if (f.queue == A1IN) {
+    if (f.fifoPrev >= 0) frames[f.fifoPrev].fifoNext = f.fifoNext; else s.inHead = f.fifoNext;
+    if (f.fifoNext >= 0) frames[f.fifoNext].fifoPrev = f.fifoPrev; else s.inTail = f.fifoPrev;
+    s.inCount--;
+  } else if (f.queue == AM) {
+    s.mainCount--;
+  }
+
+  f.file = NULL;
+  f.queue = FREE;
+  f.fifoPrev = f.fifoNext = -1;
+  f.referenced = false;
+  f.dirty = false;
+  f.pinCount = 0;
+
+  // put the frame on the free list
+  f.next = s.freeList;
+  s.freeList = frame;
+}
+
+int BufferPool::victimInA1in(Stripe& s)
+{
+  // the oldest unpinned page in the FIFO
+  for (int i = s.inHead; i >= 0; i = frames[i].fifoNext) {
+    if (frames[i].pinCount == 0) return i;
+  }
+  return -1;
+}
+
+int BufferPool::victimInAm(Stripe& s)
+{
+  // advance the clock hand until we meet an unpinned page of Am whose
+  // second chance is used up. referenced frames get cleared on the way,
+  // so two sweeps without a victim mean all pages of Am are pinned.
+  if (s.mainCount == 0) return -1;
+  for (int steps = 0; steps <= 2 * s.count; steps++) {
+    int i = s.first + s.hand;
+    s.hand = (s.hand + 1) % s.count;
+    if (frames[i].queue != AM || frames[i].pinCount > 0) continue;
+    if (!frames[i].referenced) return i;
+    frames[i].referenced = false;
+  }
+  return -1;
+}
+
+void BufferPool::addGhost(Stripe& s, size_t h)
+{
+  if (s.ghosts.empty()) return;
+
+  // the ring is full. forget the oldest ghost
+  if (s.ghostCount == (int) s.ghosts.size()) {
+    std::unordered_map<size_t, int>::iterator it = s.ghostIndex.find(s.ghosts[s.ghostNext]);
+    if (it != s.ghostIndex.end() && --it->second == 0) s.ghostIndex.erase(it);
+    s.ghostCount--;
+  }
+
+  s.ghosts[s.ghostNext] = h;
+  s.ghostNext = (s.ghostNext + 1) % (int) s.ghosts.size();
+  s.ghostCount++;
+  s.ghostIndex[h]++;
+}
+
+bool BufferPool::takeGhost(Stripe& s, size_t h)
+{
+  // the ring slot is left in place and ages out. only the index entry
+  // is dropped, so that the page is not admitted again from A1out.
+  std::unordered_map<size_t, int>::iterator it = s.ghostIndex.find(h);
+  if (it == s.ghostIndex.end()) return false;
+  s.ghostIndex.erase(it);
+  return true;
+}
+
+RC BufferPool::allocate(Stripe& s, unique_lock<mutex>& guard, size_t h, const PageFile* file,
+                        PageId pid, PageKind kind, int& frame, bool& cached)
+{
+  RC  rc;
+
+  // without an empty frame, evict a page. take it from A1in while A1in
+  // is over its share, so that pages read once leave first.
+  cached = false;
+  while (s.freeList < 0) {
+    int victim = -1;
+    bool fromA1in = false;
+    if (s.inCount > s.inLimit || s.mainCount == 0) {
+      victim = victimInA1in(s);
+      fromA1in = (victim >= 0);
+    }
+    if (victim < 0) victim = victimInAm(s);
+    if (victim < 0) {
+      victim = victimInA1in(s);
+      fromA1in = (victim >= 0);
+    }
+    if (victim < 0) return RC_CACHE_FULL;
+
+    // a modified page must reach the disk before its frame is reused.
+    // as in writeBack(), a pinned snapshot is written with the stripe
+    // unlocked, so that readers of the stripe do not wait for the write
+    // (and the log flush before it).
+    Frame& v = frames[victim];
+    if (v.dirty) {
+      const PageFile* vfile = v.file;
+      PageId vpid = v.pid;
+      PageKind vkind = v.kind;
+      long long lsn = v.lsn;
+      void* copy = NULL;
+      if (posix_memalign(&copy, FRAME_ALIGNMENT, pageSize) != 0) return RC_FILE_WRITE_FAILED;
+      memcpy(copy, v.data, pageSize);
+      v.dirty = false;
+      v.pinCount++;
+
+      guard.unlock();
+      rc = vfile->writePage(vpid, copy, vkind, lsn);
+      free(copy);
+      guard.lock();
+
+      bool same = (v.file == vfile && v.pid == vpid);
+      if (same && v.pinCount > 0) v.pinCount--;
+      if (rc < 0) {
+        if (same) v.dirty = true;
+        return rc;
+      }
+
+      // another thread may have loaded the page in the meantime
+      if ((frame = lookup(s, h, file, pid)) >= 0) {
+        cached = true;
+        return 0;
+      }
+
+      // the victim may have been used, written or pinned in the
+      // meantime. if so, look for a victim again.
+      if (!same || v.dirty || v.pinCount > 0 || (v.queue == AM && v.referenced)) continue;
+    }
+    v.file->stats->eviction(v.kind);
+    if (fromA1in) addGhost(s, hash(v.file, v.pid));
+    unlink(s, victim);
+  }
+
+  // take an empty frame
+  frame = s.freeList;
+  s.freeList = frames[frame].next;
+  Frame& f = frames[frame];
+
+  // register the frame for the new page
+  int b = bucketOf(s, h);
+  f.file = file;
+  f.pid = pid;
+  f.kind = kind;
+  f.referenced = false;
+  f.next = s.buckets[b];
+  s.buckets[b] = frame;
+
+  // a page seen again shortly after it left A1in goes to Am.
+  // any other page starts in A1in.
+  if (takeGhost(s, h)) {
+    f.queue = AM;
+    s.mainCount++;
+  } else {
+    f.queue = A1IN;
+    f.fifoPrev = s.inTail;
+    f.fifoNext = -1;
+    if (s.inTail >= 0) frames[s.inTail].fifoNext = frame; else s.inHead = frame;
+    s.inTail = frame;
+    s.inCount++;
+  }
+
+  return 0;
+}
+
+void BufferPool::touch(Stripe& s, int frame, bool repeat)
+{
+  Frame& f = frames[frame];
+
+  if (f.queue == AM) {
+    f.referenced = true;
+    return;
+  }
+
+  // in A1in, the first access only marks the page. a page accessed
+  // again in a later burst has proven itself, so it moves to Am.
+  if (!f.referenced) {
+    f.referenced = true;
+    return;
+  }
+  if (repeat) return;
+
+  if (f.fifoPrev >= 0) frames[f.fifoPrev].fifoNext = f.fifoNext; else s.inHead = f.fifoNext;
+  if (f.fifoNext >= 0) frames[f.fifoNext].fifoPrev = f.fifoPrev; else s.inTail = f.fifoPrev;
+  f.fifoPrev = f.fifoNext = -1;
+  s.inCount--;
+  f.queue = AM;
+  s.mainCount++;
+}
+
+RC BufferPool::fetch(Stripe& s, unique_lock<mutex>& guard, size_t h, const PageFile* file,
+                     PageId pid, PageKind kind, int& frame, bool repeat)
+{
+  RC rc;
+  bool cached;
+
+  // if the page is in the pool, we are done
+  frame = lookup(s, h, file, pid);
+  if (frame >= 0) {
+    file->stats->hit(kind);
+    touch(s, frame, repeat);
+    return 0;
+  }
+
+  // otherwise, read the page into a victim frame
+  file->stats->miss(kind);
+  if ((rc = allocate(s, guard, h, file, pid, kind, frame, cached)) < 0) return rc;
+  if (cached) {
+    touch(s, frame, repeat);
+    return 0;
+  }
+  if ((rc = file->readPage(pid, frames[frame].data, kind)) < 0) {
+    unlink(s, frame);
+    return rc;
+  }
+  frames[frame].referenced = true;
+
+  return 0;
+}
+
+RC BufferPool::read(const PageFile* file, PageId pid, void* buffer, PageKind kind, bool repeat)
+{
+  RC  rc;
+  int frame;
+  size_t h = hash(file, pid);
+  Stripe& s = stripeOf(h);
+  unique_lock<mutex> guard(s.lock);
+
+  if ((rc = fetch(s, guard, h, file, pid, kind, frame, repeat)) < 0) return rc;
+  memcpy(buffer, frames[frame].data, pageSize);
+
+  return 0;
+}
+
+RC BufferPool::write(const PageFile* file, PageId pid, const void* buffer, PageKind kind, long long lsn)
+{
+  RC  rc;
+  bool cached;
+  size_t h = hash(file, pid);
+  Stripe& s = stripeOf(h);
+  unique_lock<mutex> guard(s.lock);
+
+  // find the page in the pool, or give it a frame
+  int frame = lookup(s, h, file, pid);
+  if (frame < 0 && (rc = allocate(s, guard, h, file, pid, kind, frame, cached)) < 0) return rc;
+
+  memcpy(frames[frame].data, buffer, pageSize);
+  frames[frame].kind = kind;
+  frames[frame].lsn = lsn;
+  frames[frame].dirty = true;
+
+  return 0;
+}
+
+bool BufferPool::peek(const PageFile* file, PageId pid, void* buffer)
+{
+  size_t h = hash(file, pid);
+  Stripe& s = stripeOf(h);
+  lock_guard<mutex> guard(s.lock);
+
+  int frame = lookup(s, h, file, pid);
+  if (frame < 0) return false;
+  memcpy(buffer, frames[frame].data, pageSize);
+
+  return true;
+}
+
+RC BufferPool::install(const PageFile* file, PageId pid, void* buffer, PageKind kind)
+{
+  RC  rc;
+  size_t h = hash(file, pid);
+  Stripe& s = stripeOf(h);
+  unique_lock<mutex> guard(s.lock);
+
+  int frame = lookup(s, h, file, pid);
+  bool cached = (frame >= 0);
+  if (!cached && (rc = allocate(s, guard, h, file, pid, kind, frame, cached)) < 0) return rc;
+
+  // if the page got cached in the meantime, the cached copy is newer
+  if (cached) {
+    memcpy(buffer, frames[frame].data, pageSize);
+  } else {
+    memcpy(frames[frame].data, buffer, pageSize);
+  }
+
+  return 0;
+}
+
+RC BufferPool::pin(const PageFile* file, PageId pid, const char*& page, PageKind kind, bool repeat)
+{
+  RC  rc;
+  int frame;
+  size_t h = hash(file, pid);
+  Stripe& s = stripeOf(h);
+  unique_lock<mutex> guard(s.lock);
+
+  if ((rc = fetch(s, guard, h, file, pid, kind, frame, repeat)) < 0) return rc;
+  frames[frame].pinCount++;
+  page = frames[frame].data;
+
+  return 0;
+}
+
+void BufferPool::unpin(const PageFile* file, PageId pid)
+{
+  size_t h = hash(file, pid);
+  Stripe& s = stripeOf(h);
+  lock_guard<mutex> guard(s.lock);
+
+  int frame = lookup(s, h, file, pid);
+  if (frame >= 0 && frames[frame].pinCount > 0) frames[frame].pinCount--;
+}
+
+void BufferPool::collectDirty(const PageFile* file, vector<std::pair<PageId, int> >& dirty)
+{
+  dirty.clear();
+  for (unsigned k = 0; k < stripes.size(); k++) {
+    Stripe& s = *stripes[k];
+    lock_guard<mutex> guard(s.lock);
+    for (int i = s.first; i < s.first + s.count; i++) {
+      if (frames[i].file == file && frames[i].dirty) {
+        dirty.push_back(std::make_pair(frames[i].pid, i));
+      }
+    }
+  }
+
+  // write them in pid order, so that the disk sees one forward sweep
+  std::sort(dirty.begin(), dirty.end());
+}
+
+RC BufferPool::flushFile(const PageFile* file)
+{
+  RC rc;
+  vector<std::pair<PageId, int> > dirty;  // (pid, frame) of dirty pages
+  collectDirty(file, dirty);
+
+  // a frame may have been written back or reused since we looked at it,
+  // so check it again under its stripe lock.
+  for (unsigned i = 0; i < dirty.size(); i++) {
+    Frame& f = frames[dirty[i].second];
+    Stripe& s = stripeOf(hash(file, dirty[i].first));
+    lock_guard<mutex> guard(s.lock);
+    if (f.file != file || f.pid != dirty[i].first || !f.dirty) continue;
+    if ((rc = file->writePage(f.pid, f.data, f.kind, f.lsn)) < 0) return rc;
+    f.dirty = false;
+  }
+
+  return 0;
+}
+
+RC BufferPool::writeBack(const PageFile* file)
+{
+  RC rc = 0;
+  vector<std::pair<PageId, int> > dirty;  // (pid, frame) of dirty pages
+  collectDirty(file, dirty);
+  if (dirty.empty()) return 0;
+
+  // the copy is aligned like a frame, so a file in 'b' mode can write it
+  void* copy = NULL;
+  if (posix_memalign(&copy, FRAME_ALIGNMENT, pageSize) != 0) return RC_FILE_WRITE_FAILED;
+
+  for (unsigned i = 0; i < dirty.size() && rc == 0; i++) {
+    Frame& f = frames[dirty[i].second];
+    Stripe& s = stripeOf(hash(file, dirty[i].first));
+    PageKind kind;
+    long long lsn;
+
+    // take a snapshot of the page and mark it clean. the pin keeps the
+    // frame from being evicted (and the page read back from the disk)
+    // before the snapshot is written. a write in the meantime makes
+    // the page dirty again.
+    {
+      lock_guard<mutex> guard(s.lock);
+      if (f.file != file || f.pid != dirty[i].first || !f.dirty) continue;
+      memcpy(copy, f.data, pageSize);
+      kind = f.kind;
+      lsn = f.lsn;
+      f.dirty = false;
+      f.pinCount++;
+    }
+
+    // the stripe stays unlocked during the write
+    rc = file->writePage(dirty[i].first, copy, kind, lsn);
+
+    {
+      lock_guard<mutex> guard(s.lock);
+      f.pinCount--;
+      if (rc < 0) f.dirty = true;
+    }
+  }
+
+  free(copy);
+  return rc;
+}
+
+void BufferPool::invalidateFile(const PageFile* file)
+{
+  for (unsigned k = 0; k < stripes.size(); k++) {
+    Stripe& s = *stripes[k];
+    lock_guard<mutex> guard(s.lock);
+
+    for (int i = s.first; i < s.first + s.count; i++) {
+      if (frames[i].file == file) unlink(s, i);
+    }
+  }
+}
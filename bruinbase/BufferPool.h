@@ -0,0 +1,228 @@
+/*
+ * Copyright (C) 2008 by The Regents of the University of California
+ * Redistribution of this file is permitted under the terms of the GNU
+ * Public License (GPL).
+ *
+ * @date 3/24/2008
+ */
+
+#ifndef BUFFERPOOL_H
+#define BUFFERPOOL_H
+
+#include <cstddef>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "Bruinbase.h"
+#include "PageFile.h"
+
+/**
+ * A fixed set of in-memory page frames shared by all open PageFiles
+ * with the same page size.
+ * Pages are found through a hash table keyed by (file, pid).
+ * Victims are chosen by the 2Q algorithm, so that a scan touching many
+ * pages once cannot push out the pages that are used over and over:
+ * - a page read for the first time enters the small FIFO queue A1in.
+ *   repeated accesses in a burst (e.g., to the records of one page)
+ *   do not promote it. a page leaving A1in is remembered in the
+ *   ghost list A1out.
+ * - a page accessed again later while it is in A1in, or read again
+ *   while it is in A1out, enters the main queue Am, which is managed
+ *   by the CLOCK (second chance) algorithm.
+ * Pages are taken from A1in while it holds more than its share of the
+ * frames, and from Am otherwise.
+ * The pool is sized once at startup and never grows.
+ * Pages written through PageFile stay dirty in the pool and reach the
+ * disk only when they are evicted or their file is flushed.
+ * A pinned frame is never evicted until it is unpinned.
+ * Hits, misses and evictions of read(), pin() and write() are counted
+ * in the I/O statistics of the file, under the kind of the page.
+ *
+ * The pool is safe to use from many threads. Frames are split into
+ * stripes by the hash of (file, pid). Each stripe has its own lock,
+ * hash table and 2Q queues, so threads touching different pages
+ * rarely wait for each other. A miss holds the stripe lock while the
+ * page is read, so two threads never load the same page twice. A dirty
+ * victim is written back from a pinned snapshot with the stripe
+ * unlocked, so readers do not wait for the write and its log flush.
+ */
+class BufferPool {
+ public:
+  static const size_t DEFAULT_SIZE = 128 * 1024 * 1024; // 128MB by default
+  static const int    STRIPE_COUNT = 64;  // max # of lock stripes
+  static const size_t FRAME_ALIGNMENT = 4096; // the alignment of the frame memory
+
+  /**
+   * create a pool that holds (size / pageSize) frames.
+   * @param size[IN] the total size of the frames in bytes
+   * @param pageSize[IN] the size of a single frame in bytes
+   */
+  BufferPool(size_t size, int pageSize);
+  ~BufferPool();
+
+  /**
+   * copy a page into the memory buffer, loading it from the file on a miss.
+   * @param file[IN] the file the page belongs to
+   * @param pid[IN] the page to read
+   * @param buffer[OUT] the memory buffer to copy the page to
+   * @param kind[IN] the kind of the page
+   * @param repeat[IN] true if the file accessed the same page just before.
+   *   such an access belongs to the same burst and does not promote the page
+   * @return error code. 0 if no error
+   */
+  RC read(const PageFile* file, PageId pid, void* buffer, PageKind kind, bool repeat = false);
+
+  /**
+   * copy the memory buffer into the cached page and mark it dirty.
+   * the page is not read from the file first, since it is fully overwritten.
+   * @param file[IN] the file the page belongs to
+   * @param pid[IN] the page to write
+   * @param buffer[IN] the new content of the page
+   * @param kind[IN] the kind of the page
+   * @param lsn[IN] the LSN of the log record of the write. 0 if not logged
+   * @return error code. 0 if no error
+   */
+  RC write(const PageFile* file, PageId pid, const void* buffer, PageKind kind, long long lsn = 0);
+
+  /**
+   * copy a page into the memory buffer only if it is cached.
+   * @param file[IN] the file the page belongs to
+   * @param pid[IN] the page to read
+   * @param buffer[OUT] the memory buffer to copy the page to
+   * @return true if the page was cached
+   */
+  bool peek(const PageFile* file, PageId pid, void* buffer);
+
+  /**
+   * add a clean page that was read from the file to the pool.
+   * if the page got cached in the meantime, the cached copy is newer,
+   * so it is copied into the buffer instead.
+   * @param file[IN] the file the page belongs to
+   * @param pid[IN] the page to add
+   * @param buffer[IN/OUT] the page content read from the file
+   * @param kind[IN] the kind of the page
+   * @return error code. RC_CACHE_FULL if every candidate frame is pinned
+   */
+  RC install(const PageFile* file, PageId pid, void* buffer, PageKind kind);
+
+  /**
+   * load a page if needed and protect its frame from eviction. pins nest.
+   * @param file[IN] the file the page belongs to
+   * @param pid[IN] the page to pin
+   * @param page[OUT] the frame holding the page
+   * @param kind[IN] the kind of the page
+   * @param repeat[IN] true if the file accessed the same page just before
+   * @return error code. RC_CACHE_FULL if every candidate frame is pinned
+   */
+  RC pin(const PageFile* file, PageId pid, const char*& page, PageKind kind, bool repeat = false);
+
+  /**
+   * release one pin of a page.
+   * @param file[IN] the file the page belongs to
+   * @param pid[IN] the page to unpin
+   */
+  void unpin(const PageFile* file, PageId pid);
+
+  /**
+   * write every dirty page of a file back to the disk in pid order.
+   * @param file[IN] the file whose pages are flushed
+   * @return error code. 0 if no error
+   */
+  RC flushFile(const PageFile* file);
+
+  /**
+   * write every dirty page of a file back to the disk in pid order,
+   * while other threads keep reading and writing the file. each page is
+   * copied under its stripe lock and written without holding it, so
+   * readers wait for a memcpy at most. a page written again during the
+   * write-back stays dirty.
+   * @param file[IN] the file whose pages are written back
+   * @return error code. 0 if no error
+   */
+  RC writeBack(const PageFile* file);
+
+  /**
+   * drop every cached page of a file. dirty pages are discarded.
+   * @param file[IN] the file whose pages are dropped
+   */
+  void invalidateFile(const PageFile* file);
+
+  /**
+   * @return the number of frames in the pool
+   */
+  int getFrameCount() const { return (int) frames.size(); }
+
+ private:
+  // the queue a frame belongs to
+  enum Queue { FREE, A1IN, AM };
+
+  struct Frame {
+    const PageFile* file; // the file of the cached page. NULL if the frame is empty
+    PageId pid;           // the cached page
+    PageKind kind;        // the kind of the cached page, for the I/O statistics
+    Queue  queue;         // the 2Q queue of the frame
+    bool   referenced;    // in Am, the second-chance bit for the CLOCK algorithm.
+                          // in A1in, set once the page has been accessed
+    bool   dirty;         // true if the page was modified since it was read
+    long long lsn;        // the LSN of the last logged write of the page
+    int    pinCount;      // # of outstanding pins. pinned frames are not evicted
+    int    next;          // next frame in the same hash bucket or the free list
+    int    fifoPrev;      // previous frame in A1in (-1 at the head)
+    int    fifoNext;      // next frame in A1in (-1 at the tail)
+    char*  data;          // the page content
+  };
+
+  struct Stripe {
+    std::mutex lock;          // protects every frame and bucket of the stripe
+    int first;                // the first frame of the stripe
+    int count;                // # of frames in the stripe
+    int hand;                 // current position of the clock hand in Am
+    int freeList;             // the first empty frame (-1 if none)
+    int inHead;               // the oldest frame in A1in (-1 if empty)
+    int inTail;               // the newest frame in A1in (-1 if empty)
+    int inCount;              // # of frames in A1in
+    int inLimit;              // the share of the frames A1in may keep
+    int mainCount;            // # of frames in Am
+    std::vector<int> buckets; // hash table: head frame of each bucket chain
+
+    // the ghost list A1out. it keeps only the hash of each page, so a
+    // rare collision merely admits a page to Am a little early.
+    std::vector<size_t> ghosts;                 // ring of page hashes
+    int ghostNext;                              // the next ring slot to fill
+    int ghostCount;                             // # of ring slots in use
+    std::unordered_map<size_t, int> ghostIndex; // # of ring slots per hash
+  };
+
+  std::vector<Frame> frames;     // the page frames of all stripes
+  std::vector<Stripe*> stripes;  // the lock stripes
+  char* memory;                  // the memory backing all frames
+  int   pageSize;                // the size of a frame
+
+  size_t  hash(const PageFile* file, PageId pid) const;
+  Stripe& stripeOf(size_t h) { return *stripes[h % stripes.size()]; }
+  int     bucketOf(const Stripe& s, size_t h) const
+            { return (int) ((h >> 32) & (s.buckets.size() - 1)); }
+
+  // the dirty pages of a file as (pid, frame), sorted by pid.
+  // takes the stripe locks one at a time
+  void collectDirty(const PageFile* file, std::vector<std::pair<PageId, int> >& dirty);
+
+  // the following functions must be called with the stripe lock held.
+  // allocate() and fetch() release the lock while a dirty victim is
+  // written back. if another thread cached the page in the meantime,
+  // allocate() returns its frame and sets cached
+  int  lookup(Stripe& s, size_t h, const PageFile* file, PageId pid);
+  RC   allocate(Stripe& s, std::unique_lock<std::mutex>& guard, size_t h, const PageFile* file,
+                PageId pid, PageKind kind, int& frame, bool& cached);
+  RC   fetch(Stripe& s, std::unique_lock<std::mutex>& guard, size_t h, const PageFile* file,
+             PageId pid, PageKind kind, int& frame, bool repeat);
+  void touch(Stripe& s, int frame, bool repeat);
+  void unlink(Stripe& s, int frame);
+  int  victimInA1in(Stripe& s);
+  int  victimInAm(Stripe& s);
+  void addGhost(Stripe& s, size_t h);
+  bool takeGhost(Stripe& s, size_t h);
+};
+
+#endif // BUFFERPOOL_H
@@ -0,0 +1,126 @@
+/**
+ * Copyright (C) 2008 by The Regents of the University of California
+ * Redistribution of this file is permitted under the terms of the GNU
+ * Public License (GPL).
+ *
+ * @date 3/24/2008
+ */
+
+#include "IOStats.h"
+#include <map>
+#include <mutex>
+
+using std::string;
+using std::vector;
+
+// the statistics of every file seen so far, by file name
+static std::map<string, IOStats*> registry;
+static std::mutex registryLock;
+
+long long PageStats::percentile(const long long histogram[], int percent)
+{
+  long long total = 0;
+  for (int i = 0; i < LATENCY_BUCKETS; i++) total += histogram[i];
+  if (total == 0) return 0;
+
+  // find the first bucket where the running count reaches the percentile
+  long long target = (total * percent + 99) / 100;
+  long long sum = 0;
+  for (int i = 0; i < LATENCY_BUCKETS; i++) {
+    sum += histogram[i];
+    if (sum >= target) return 1LL << i;
+  }
+  return 1LL << (LATENCY_BUCKETS - 1);
+}
+
+IOStats::IOStats()
+{
+  reset();
+}
+
+IOStats* IOStats::forFile(const string& filename)
+{
+  std::lock_guard<std::mutex> guard(registryLock);
+  IOStats*& s = registry[filename];
+  if (s == NULL) s = new IOStats;
+  return s;
+}
+
+void IOStats::getFileNames(vector<string>& names)
+{
+  std::lock_guard<std::mutex> guard(registryLock);
+  names.clear();
+  for (std::map<string, IOStats*>::const_iterator it = registry.begin(); it != registry.end(); ++it) {
+    names.push_back(it->first);
+  }
+}
+
+void IOStats::resetAll()
+{
+  std::lock_guard<std::mutex> guard(registryLock);
+  for (std::map<string, IOStats*>::iterator it = registry.begin(); it != registry.end(); ++it) {
+    it->second->reset();
+  }
+}
+
+const char* IOStats::kindName(PageKind kind)
+{
+  switch (kind) {
+  case PAGE_RECORD:   return "record";
+  case PAGE_LEAF:     return "leaf";
+  case PAGE_INTERNAL: return "internal";
+  case PAGE_META:     return "meta";
+  default:            return "unknown";
+  }
+}
+
+int IOStats::bucketOf(long long usec)
+{
+  int b = 0;
+  while (usec > 0 && b < PageStats::LATENCY_BUCKETS - 1) {
+    usec >>= 1;
+    b++;
+  }
+  return b;
+}
+
+void IOStats::read(PageKind kind, long long bytes, long long usec)
+{
+  add(kind, READS, 1);
+  add(kind, READ_BYTES, bytes);
+  readLatency[kind][bucketOf(usec)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void IOStats::write(PageKind kind, long long bytes, long long usec)
+{
+  add(kind, WRITES, 1);
+  add(kind, WRITE_BYTES, bytes);
+  writeLatency[kind][bucketOf(usec)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void IOStats::get(PageKind kind, PageStats& stats) const
+{
+  stats.hits = counters[kind][HITS];
+  stats.misses = counters[kind][MISSES];
+  stats.prefetches = counters[kind][PREFETCHES];
+  stats.evictions = counters[kind][EVICTIONS];
+  stats.reads = counters[kind][READS];
+  stats.writes = counters[kind][WRITES];
+  stats.readBytes = counters[kind][READ_BYTES];
+  stats.writeBytes = counters[kind][WRITE_BYTES];
+  for (int i = 0; i < PageStats::LATENCY_BUCKETS; i++) {
+    stats.readLatency[i] = readLatency[kind][i];
+    stats.writeLatency[i] = writeLatency[kind][i];
+  }
+}
+
+void IOStats::reset()
+{
+  for (int k = 0; k < PAGE_KIND_COUNT; k++) {
+    for (int c = 0; c < COUNTER_COUNT; c++) counters[k][c] = 0;
+    for (int i = 0; i < PageStats::LATENCY_BUCKETS; i++) {
+      readLatency[k][i] = 0;
+      writeLatency[k][i] = 0;
+    }
+  }
+}
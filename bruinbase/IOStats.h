@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2008 by The Regents of the University of California
+ * Redistribution of this file is permitted under the terms of the GNU
+ * Public License (GPL).
+ *
+ * @date 3/24/2008
+ */
+
+#ifndef IOSTATS_H
+#define IOSTATS_H
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+/**
+ * The kind of data a page holds. The I/O statistics are kept per kind.
+ */
+enum PageKind {
+  PAGE_RECORD,     // a page of a RecordFile
+  PAGE_LEAF,       // a B+tree leaf node
+  PAGE_INTERNAL,   // a B+tree non-leaf node
+  PAGE_META,       // file and index metadata, free pages
+  PAGE_KIND_COUNT
+};
+
+/**
+ * A snapshot of the I/O statistics of one kind of page in one file.
+ */
+struct PageStats {
+  // bucket 0 counts I/Os that took less than 1us. bucket i > 0 counts
+  // I/Os that took [2^(i-1), 2^i) us. the last bucket takes the rest.
+  static const int LATENCY_BUCKETS = 24;
+
+  long long hits;        // accesses served from memory
+  long long misses;      // accesses that had to read the page from the disk
+  long long prefetches;  // pages requested from the disk ahead of the accesses
+  long long evictions;   // pages dropped from the buffer pool to make room
+  long long reads;       // # of read system calls
+  long long writes;      // # of write system calls
+  long long readBytes;   // # of bytes read from the disk
+  long long writeBytes;  // # of bytes written to the disk
+  long long readLatency[LATENCY_BUCKETS];  // histogram of the read latencies
+  long long writeLatency[LATENCY_BUCKETS]; // histogram of the write latencies
+
+  /**
+   * estimate a percentile of a latency histogram.
+   * @param histogram[IN] readLatency or writeLatency
+   * @param percent[IN] the percentile to find, e.g., 99
+   * @return the upper bound of the bucket holding the percentile in us.
+   *   0 if the histogram is empty
+   */
+  static long long percentile(const long long histogram[], int percent);
+};
+
+/**
+ * The I/O statistics of a file, kept per page kind.
+ * The statistics of a file live as long as the program, so they add up
+ * over every time the file is opened. They are found by file name.
+ * All counters may be updated from many threads at once.
+ */
+class IOStats {
+ public:
+  /**
+   * find the statistics of a file, creating them on the first use.
+   * @param filename[IN] the name of the file
+   * @return the statistics of the file. never deleted
+   */
+  static IOStats* forFile(const std::string& filename);
+
+  /**
+   * get the names of all files that have statistics, in sorted order.
+   * @param names[OUT] the file names
+   */
+  static void getFileNames(std::vector<std::string>& names);
+
+  /**
+   * clear the statistics of all files.
+   */
+  static void resetAll();
+
+  /**
+   * @return the name of a page kind, e.g., "leaf"
+   */
+  static const char* kindName(PageKind kind);
+
+  void hit(PageKind kind)        { add(kind, HITS, 1); }
+  void miss(PageKind kind)       { add(kind, MISSES, 1); }
+  void prefetch(PageKind kind)   { add(kind, PREFETCHES, 1); }
+  void eviction(PageKind kind)   { add(kind, EVICTIONS, 1); }
+
+  /**
+   * count a read system call.
+   * @param kind[IN] the kind of the pages read
+   * @param bytes[IN] # of bytes read
+   * @param usec[IN] how long the read took in microseconds
+   */
+  void read(PageKind kind, long long bytes, long long usec);
+
+  /**
+   * count a write system call.
+   * @param kind[IN] the kind of the pages written
+   * @param bytes[IN] # of bytes written
+   * @param usec[IN] how long the write took in microseconds
+   */
+  void write(PageKind kind, long long bytes, long long usec);
+
+  /**
+   * take a snapshot of the statistics of one page kind.
+   * @param kind[IN] the page kind
+   * @param stats[OUT] the statistics
+   */
+  void get(PageKind kind, PageStats& stats) const;
+
+  /**
+   * clear all counters.
+   */
+  void reset();
+
+ private:
+  enum Counter { HITS, MISSES, PREFETCHES, EVICTIONS,
+                 READS, WRITES, READ_BYTES, WRITE_BYTES, COUNTER_COUNT };
+
+  std::atomic<long long> counters[PAGE_KIND_COUNT][COUNTER_COUNT];
+  std::atomic<long long> readLatency[PAGE_KIND_COUNT][PageStats::LATENCY_BUCKETS];
+  std::atomic<long long> writeLatency[PAGE_KIND_COUNT][PageStats::LATENCY_BUCKETS];
+
+  IOStats();
+  void add(PageKind kind, Counter c, long long n)
+    { counters[kind][c].fetch_add(n, std::memory_order_relaxed); }
+  static int bucketOf(long long usec);
+};
+
+#endif // IOSTATS_H
@@ -0,0 +1,149 @@
+/**
+ * Copyright (C) 2008 by The Regents of the University of California
+ * Redistribution of this file is permitted under the terms of the GNU
+ * Public License (GPL).
+ *
+ * @date 3/24/2008
+ */
+
+#include "PageCodec.h"
+#include <cstring>
+#include <stdint.h>
+
+static const int MIN_MATCH = 4;       // the shortest match worth a reference
+static const int MAX_OFFSET = 65535;  // the farthest match a 2-byte offset reaches
+static const int HASH_BITS = 12;      // the size of the match finder table
+
+static uint32_t read32(const char* p)
+{
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+// write a length that did not fit into its 4-bit field of the token
+static bool putLength(char*& op, const char* end, int length)
+{
+  for (; length >= 255; length -= 255) {
+    if (op >= end) return false;
+    *op++ = (char) 255;
+  }
+  if (op >= end) return false;
+  *op++ = (char) length;
+  return true;
+}
+
+static bool getLength(const unsigned char*& ip, const unsigned char* end, int& length)
+{
+  unsigned char b;
+  do {
+    if (ip >= end) return false;
+    b = *ip++;
+    length += b;
+  } while (b == 255);
+  return true;
+}
+
+// emit one sequence: the literals [lit, lit + litLength) and a match of
+// matchLength bytes at offset. matchLength 0 emits the last sequence.
+static bool putSequence(char*& op, const char* end, const char* lit, int litLength,
+                        int offset, int matchLength)
+{
+  if (op >= end) return false;
+  char* token = op++;
+  int litCode = (litLength < 15) ? litLength : 15;
+  int matchCode = 0;
+  if (matchLength > 0) {
+    matchCode = matchLength - MIN_MATCH;
+    if (matchCode > 15) matchCode = 15;
+  }
+  *token = (char) ((litCode << 4) | matchCode);
+
+  if (litCode == 15 && !putLength(op, end, litLength - 15)) return false;
+  if (end - op < litLength) return false;
+  memcpy(op, lit, litLength);
+  op += litLength;
+
+  if (matchLength == 0) return true;
+  if (end - op < 2) return false;
+  *op++ = (char) (offset & 0xff);
+  *op++ = (char) (offset >> 8);
+  if (matchCode == 15 && !putLength(op, end, matchLength - MIN_MATCH - 15)) return false;
+  return true;
+}
+
+int PageCodec::compress(const char* src, int size, char* dst, int capacity)
+{
+  // the last position of the table entry + 1. 0 marks an empty entry
+  int table[1 << HASH_BITS];
+  memset(table, 0, sizeof(table));
+
+  char* op = dst;
+  const char* end = dst + capacity;
+  int anchor = 0;  // the first byte not yet emitted
+  int ip = 0;
+
+  while (ip + MIN_MATCH <= size) {
+    uint32_t seq = read32(src + ip);
+    int h = (int) ((seq * 2654435761u) >> (32 - HASH_BITS));
+    int ref = table[h] - 1;
+    table[h] = ip + 1;
+
+    if (ref < 0 || ip - ref > MAX_OFFSET || read32(src + ref) != seq) {
+      ip++;
+      continue;
+    }
+
+    // extend the match as far as it goes
+    int length = MIN_MATCH;
+    while (ip + length < size && src[ref + length] == src[ip + length]) length++;
+
+    if (!putSequence(op, end, src + anchor, ip - anchor, ip - ref, length)) return -1;
+    ip += length;
+    anchor = ip;
+  }
+
+  if (!putSequence(op, end, src + anchor, size - anchor, 0, 0)) return -1;
+  return (int) (op - dst);
+}
+
+RC PageCodec::decompress(const char* src, int srcSize, char* dst, int size)
+{
+  const unsigned char* ip = (const unsigned char*) src;
+  const unsigned char* end = ip + srcSize;
+  int op = 0;
+
+  while (op < size) {
+    if (ip >= end) return RC_FILE_READ_FAILED;
+    int token = *ip++;
+
+    // copy the literals
+    int litLength = token >> 4;
+    if (litLength == 15 && !getLength(ip, end, litLength)) return RC_FILE_READ_FAILED;
+    if (end - ip < litLength || size - op < litLength) return RC_FILE_READ_FAILED;
+    memcpy(dst + op, ip, litLength);
+    ip += litLength;
+    op += litLength;
+    if (op == size) break;
+
+    // copy the match. it may overlap the bytes it produces,
+    // e.g., a run of zeros refers to the byte right before it
+    if (end - ip < 2) return RC_FILE_READ_FAILED;
+    int offset = ip[0] | (ip[1] << 8);
+    ip += 2;
+    int matchLength = token & 15;
+    if (matchLength == 15 && !getLength(ip, end, matchLength)) return RC_FILE_READ_FAILED;
+    matchLength += MIN_MATCH;
+    if (offset == 0 || offset > op || size - op < matchLength) return RC_FILE_READ_FAILED;
+
+    const char* from = dst + op - offset;
+    if (offset >= matchLength) {
+      memcpy(dst + op, from, matchLength);
+    } else {
+      for (int i = 0; i < matchLength; i++) dst[op + i] = from[i];
+    }
+    op += matchLength;
+  }
+
+  return 0;
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2008 by The Regents of the University of California
+ * Redistribution of this file is permitted under the terms of the GNU
+ * Public License (GPL).
+ *
+ * @date 3/24/2008
+ */
+
+#ifndef PAGECODEC_H
+#define PAGECODEC_H
+
+#include "Bruinbase.h"
+
+/**
+ * A small and fast LZ77 codec for page images.
+ * Repeated byte sequences up to 64KB back are replaced by a reference
+ * to the earlier copy, so the zero padding of record slots and B+tree
+ * nodes shrinks to a few bytes.
+ *
+ * The compressed data is a series of sequences. Each sequence is a
+ * token byte (the literal length in the high 4 bits and the match
+ * length - 4 in the low 4 bits), more literal length bytes if the
+ * literal length is 15 or more, the literals, a 2-byte little-endian
+ * match offset, and more match length bytes if needed. A length field
+ * of 15 is continued by bytes that are added to it until a byte below
+ * 255. The last sequence has only literals and ends the data.
+ */
+class PageCodec {
+ public:
+  /**
+   * compress a page.
+   * @param src[IN] the page to compress
+   * @param size[IN] the size of the page. at most 64KB
+   * @param dst[OUT] the buffer for the compressed data
+   * @param capacity[IN] the size of dst
+   * @return the size of the compressed data. -1 if it does not fit
+   *   into capacity bytes
+   */
+  static int compress(const char* src, int size, char* dst, int capacity);
+
+  /**
+   * decompress a page compressed by compress().
+   * @param src[IN] the compressed data
+   * @param srcSize[IN] the size of the compressed data
+   * @param dst[OUT] the buffer for the page
+   * @param size[IN] the size of the page
+   * @return error code. RC_FILE_READ_FAILED if the data is corrupt
+   */
+  static RC decompress(const char* src, int srcSize, char* dst, int size);
+};
+
+#endif // PAGECODEC_H
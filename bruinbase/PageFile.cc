@@ -9,47 +9,195 @@
 
 #include "Bruinbase.h"
 #include "PageFile.h"
+#include "BufferPool.h"
+#include "PageCodec.h"
+#include "WriteAheadLog.h"
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <chrono>
 #include <cstring>
+#include <map>
+#include <mutex>
+#include <vector>
 #include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 using std::string;
+using std::vector;
 
-int PageFile::readCount = 0;
-int PageFile::writeCount = 0;
-int PageFile::cacheClock = 1;
-struct PageFile::cacheStruct PageFile::readCache[PageFile::CACHE_COUNT];
+std::atomic<int> PageFile::readCount(0);
+std::atomic<int> PageFile::writeCount(0);
+size_t PageFile::cacheSize = BufferPool::DEFAULT_SIZE;
+int PageFile::defaultPageSize = PageFile::PAGE_SIZE;
+WriteAheadLog* PageFile::wal = NULL;
+
+// the buffer pools, one for each page size in use.
+// a pool is created when the first file with its page size is opened.
+static std::map<int, BufferPool*> pools;
+
+// guards the creation of the buffer pools
+static std::mutex poolLock;
+
+// I/O latencies are measured with a clock that never jumps
+typedef std::chrono::steady_clock Clock;
+
+static long long elapsedUsec(Clock::time_point start)
+{
+  return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+}
+
+// make the creation of a file durable in its directory
+static RC syncDirectory(const std::string& filename)
+{
+  size_t slash = filename.rfind('/');
+  std::string dirName = (slash == std::string::npos) ? "." : filename.substr(0, slash + 1);
+  int fd = ::open(dirName.c_str(), O_RDONLY);
+  if (fd < 0) return RC_FILE_OPEN_FAILED;
+  RC rc = (::fsync(fd) < 0) ? RC_FILE_WRITE_FAILED : 0;
+  ::close(fd);
+  return rc;
+}
+
+// the header at the beginning of a file. it is padded to a full page,
+// so that the pages after it stay aligned to the page size.
+struct FileHeader {
+  int magic;       // FILE_MAGIC. files without it have no header
+  int version;     // the version of the header layout
+  int pageSize;    // the size of the pages in the file
+  PageId freeHead; // reserved for a list of free pages. always zero
+  int freeCount;   // reserved for the length of that list. always zero
+  int flags;       // FILE_COMPRESSED. zero in older headers
+  int dirCount;    // # of entries in the page directory of a compressed file
+  long long dirOffset; // where the page directory of a compressed file is
+};
+
+static const int FILE_MAGIC = 0x46504242;   // "BBPF"
+static const int FILE_VERSION = 1;
+static const int FILE_COMPRESSED = 1;       // the pages are stored compressed
+
+// where a page of a compressed file is stored
+struct PageSlot {
+  long long offset;  // the file offset of the page image
+  int length;        // the size of the image. 0 if the page was never written.
+                     // pageSize if it is stored uncompressed
+  int capacity;      // the space reserved at offset
+};
+
+// the pages of a compressed file have different sizes, so they are
+// found through a directory instead of their pid. a page is appended
+// to the end of the data, unless its new image fits into its old slot.
+// at flush(), the directory is appended after the data and the header
+// is pointed to it. the space of old images and directories is not
+// reclaimed, which suits files that are written once and read often.
+struct PageDirectory {
+  std::mutex lock;        // protects the members below
+  vector<PageSlot> slots; // the slot of each page
+  off_t end;              // the end of the data and directories
+  off_t offset;           // where the directory was last written
+  bool dirty;             // true if the slots changed since then
+};
+
+static bool isValidPageSize(int size)
+{
+  return size >= PageFile::MIN_PAGE_SIZE && size <= PageFile::MAX_PAGE_SIZE
+      && (size & (size - 1)) == 0;
+}
+
+RC PageFile::setCacheSize(size_t size)
+{
+  std::lock_guard<std::mutex> guard(poolLock);
+
+  // the pools cannot be resized once pages are cached in them
+  if (!pools.empty()) return RC_CACHE_IN_USE;
+
+  cacheSize = size;
+  return 0;
+}
+
+RC PageFile::commit()
+{
+  return (wal != NULL) ? wal->commit() : 0;
+}
+
+RC PageFile::setDefaultPageSize(int size)
+{
+  if (!isValidPageSize(size)) return RC_INVALID_PAGE_SIZE;
+  defaultPageSize = size;
+  return 0;
+}
 
 PageFile::PageFile() 
 { 
   fd = -1; 
   epid = 0; 
+  readOnly = true;
+  map = NULL;
+  mapSize = 0;
+  pageSize = PAGE_SIZE;
+  headerSize = 0;
+  pool = NULL;
+  stats = NULL;
+  dir = NULL;
+  directFd = -1;
+  bulk = false;
+  raLast = -2;
+  raEnd = 0;
+  raWindow = 0;
 }
 
 PageFile::PageFile(const string& filename, char mode)
 {
   fd = -1;
   epid = 0;
+  readOnly = true;
+  map = NULL;
+  mapSize = 0;
+  pageSize = PAGE_SIZE;
+  headerSize = 0;
+  pool = NULL;
+  stats = NULL;
+  dir = NULL;
+  directFd = -1;
+  bulk = false;
+  raLast = -2;
+  raEnd = 0;
+  raWindow = 0;
   open(filename.c_str(), mode);
 }
 
-RC PageFile::open(const string& filename, char mode)
+PageFile::~PageFile()
+{
+  // cached pages are keyed by the PageFile, so they must not outlive it
+  if (fd > 0) close();
+}
+
+RC PageFile::open(const string& filename, char mode, int pageSize, bool compress)
 {
   RC   rc;
   int  oflag;
   struct stat statbuf;
+  FileHeader  header;
 
   if (fd > 0) return RC_FILE_OPEN_FAILED;
+  if (pageSize == 0) pageSize = defaultPageSize;
+  if (!isValidPageSize(pageSize)) return RC_INVALID_PAGE_SIZE;
 
   // set the unix file flag depending on the file mode
   switch (mode) {
   case 'r':
   case 'R':
+  case 'm':
+  case 'M':
     oflag = O_RDONLY;
     break;
   case 'w':
   case 'W':
+  case 'b':
+  case 'B':
     oflag = (O_RDWR|O_CREAT);
     break;
   default:
@@ -63,30 +211,219 @@ RC PageFile::open(const string& filename, char mode)
   // get the size of the file to set the end pid
   rc = ::fstat(fd, &statbuf);
   if (rc < 0) { ::close(fd); fd = -1; return RC_FILE_OPEN_FAILED; }
-  epid = statbuf.st_size / PAGE_SIZE;
+  readOnly = (oflag == O_RDONLY);
+
+  header.flags = 0;
+
+  if (statbuf.st_size == 0 && !readOnly) {
+    // a new file. write the header with the requested page size.
+    char* block = new char[pageSize];
+    memset(block, 0, pageSize);
+    memset(&header, 0, sizeof(header));
+    header.magic = FILE_MAGIC;
+    header.version = FILE_VERSION;
+    header.pageSize = pageSize;
+    header.flags = compress ? FILE_COMPRESSED : 0;
+    memcpy(block, &header, sizeof(header));
+    ssize_t n = ::pwrite(fd, block, pageSize, 0);
+    delete [] block;
+    if (n != pageSize) { ::close(fd); fd = -1; return RC_FILE_WRITE_FAILED; }
+    // the log replays pages but not the header. it must be on disk
+    // before a logged page is, or recovery would take the file for a
+    // headerless one and write the pages to the wrong offsets.
+    if (wal != NULL && (::fsync(fd) < 0 || syncDirectory(filename) < 0)) {
+      ::close(fd); fd = -1; return RC_FILE_WRITE_FAILED;
+    }
+    this->pageSize = pageSize;
+    headerSize = pageSize;
+    statbuf.st_size = pageSize;
+  } else if (statbuf.st_size >= MIN_PAGE_SIZE &&
+             ::pread(fd, &header, sizeof(header), 0) == sizeof(header) &&
+             header.magic == FILE_MAGIC) {
+    // an existing file with a header
+    if (header.version != FILE_VERSION || !isValidPageSize(header.pageSize)) {
+      ::close(fd); fd = -1; return RC_INVALID_PAGE_SIZE;
+    }
+    this->pageSize = header.pageSize;
+    headerSize = header.pageSize;
+  } else {
+    header.flags = 0;
+    // a headerless file written before page sizes were configurable
+    this->pageSize = PAGE_SIZE;
+    headerSize = 0;
+  }
+
+  if ((statbuf.st_size - headerSize) / this->pageSize > INT_MAX) {
+    // the file has more pages than a PageId can address
+    ::close(fd); fd = -1; return RC_FILE_OPEN_FAILED;
+  }
+  epid = (statbuf.st_size - headerSize) / this->pageSize;
+
+  // a compressed file has as many pages as its directory
+  if (header.flags & FILE_COMPRESSED) {
+    dir = new PageDirectory;
+    dir->end = statbuf.st_size;
+    dir->offset = 0;
+    dir->dirty = false;
+    if (statbuf.st_size > headerSize && header.dirCount > 0) {
+      size_t bytes = (size_t) header.dirCount * sizeof(PageSlot);
+      dir->slots.resize(header.dirCount);
+      dir->offset = header.dirOffset;
+      if (::pread(fd, &dir->slots[0], bytes, header.dirOffset) != (ssize_t) bytes) {
+        delete dir; dir = NULL;
+        ::close(fd); fd = -1; return RC_FILE_READ_FAILED;
+      }
+    }
+    epid = (PageId) dir->slots.size();
+  }
+
+  raLast = -2;
+  raEnd = 0;
+  raWindow = 0;
+
+  // map the whole file in 'm' mode. if the file is too large for the
+  // address space or mmap fails, quietly fall back to plain reads.
+  if ((mode == 'm' || mode == 'M') && epid > 0 && dir == NULL &&
+      (uintmax_t) pageOffset(epid) <= (uintmax_t) SIZE_MAX) {
+    mapSize = (size_t) pageOffset(epid);
+    void* addr = ::mmap(NULL, mapSize, PROT_READ, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+      mapSize = 0;
+    } else {
+      map = (char*) addr;
+    }
+  }
+
+  // in 'b' mode, pages written back from the buffer pool bypass the OS
+  // page cache. O_DIRECT needs aligned offsets and buffers, which the
+  // header and the pool frames provide. file systems that refuse
+  // O_DIRECT (e.g., tmpfs) quietly get the plain writes, and so do
+  // compressed files, whose page images are not aligned.
+  bulk = (mode == 'b' || mode == 'B');
+  if (bulk && dir == NULL) directFd = ::open(filename.c_str(), O_WRONLY|O_DIRECT);
+
+  stats = IOStats::forFile(filename);
+  name = filename;
+
+  // the checkpoints of the log write back the pages of the file
+  if (!readOnly && wal != NULL) wal->attach(this);
+
+  // find the buffer pool for the page size, creating it if needed
+  {
+    std::lock_guard<std::mutex> guard(poolLock);
+    BufferPool*& p = pools[this->pageSize];
+    if (p == NULL) p = new BufferPool(cacheSize, this->pageSize);
+    pool = p;
+  }
 
   return 0;
 }
 
 RC PageFile::close()
 {
+  RC rc;
+
   if (fd <= 0) return RC_FILE_CLOSE_FAILED;
 
-  // close the file
-  if (::close(fd) < 0) return RC_FILE_CLOSE_FAILED;
+  // wait for a running checkpoint to finish with the file
+  if (!readOnly && wal != NULL) wal->detach(this);
+
+  // write back the dirty pages before the file goes away
+  rc = flush();
 
   // evict all cached pages for this file
-  for (int i = 0; i < CACHE_COUNT; i++) {
-    if (readCache[i].fd == fd && readCache[i].lastAccessed != 0) {
-       readCache[i].fd = 0;
-       readCache[i].pid = 0;
-       readCache[i].lastAccessed = 0;
-    }
+  pool->invalidateFile(this);
+
+  // a bulk load is not read again soon. drop whatever it left in the
+  // OS page cache, e.g., after falling back to plain writes.
+  if (bulk) {
+    closeDirect();
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    bulk = false;
   }
 
+  // drop the mapping of the file
+  if (map != NULL) {
+    ::munmap(map, mapSize);
+    map = NULL;
+    mapSize = 0;
+  }
+
+  // close the file
+  if (::close(fd) < 0) rc = RC_FILE_CLOSE_FAILED;
+  delete dir;
+  dir = NULL;
+
   // set the fd and epid to the initial state
   fd = -1; 
   epid = 0;
+  return (rc < 0) ? rc : 0;
+}
+
+RC PageFile::flush()
+{
+  RC rc;
+  if (fd <= 0) return RC_FILE_WRITE_FAILED;
+  if ((rc = pool->flushFile(this)) < 0) return rc;
+
+  // append the page directory of a compressed file after the pages.
+  // a checkpoint may write the directory at the same time, so the
+  // directory and the header are written under the directory lock.
+  std::unique_lock<std::mutex> guard;
+  if (dir != NULL) {
+    guard = std::unique_lock<std::mutex>(dir->lock);
+    if (dir->dirty && (rc = writeDirectory()) < 0) return rc;
+  }
+
+  return 0;
+}
+
+RC PageFile::writeDirectory()
+{
+  FileHeader header;
+  ssize_t bytes = (ssize_t) (dir->slots.size() * sizeof(PageSlot));
+  Clock::time_point start = Clock::now();
+  if (bytes > 0 && ::pwrite(fd, &dir->slots[0], bytes, dir->end) != bytes) {
+    return RC_FILE_WRITE_FAILED;
+  }
+  stats->write(PAGE_META, bytes, elapsedUsec(start));
+  dir->offset = dir->end;
+  dir->end += bytes;
+  dir->dirty = false;
+
+  // point the header to the new directory
+  if (::pread(fd, &header, sizeof(header), 0) != sizeof(header)) return RC_FILE_READ_FAILED;
+  header.dirCount = (int) dir->slots.size();
+  header.dirOffset = dir->offset;
+  start = Clock::now();
+  if (::pwrite(fd, &header, sizeof(header), 0) != sizeof(header)) return RC_FILE_WRITE_FAILED;
+  stats->write(PAGE_META, sizeof(header), elapsedUsec(start));
+
+  return 0;
+}
+
+RC PageFile::writeBack()
+{
+  RC rc;
+  if ((rc = pool->writeBack(this)) < 0) return rc;
+
+  // the pages of a compressed file are found through the directory
+  if (dir != NULL) {
+    std::lock_guard<std::mutex> guard(dir->lock);
+    if (dir->dirty && (rc = writeDirectory()) < 0) return rc;
+  }
+
+  return 0;
+}
+
+RC PageFile::allocatePage(PageId& pid)
+{
+  if (fd <= 0 || readOnly) return RC_FILE_WRITE_FAILED;
+
+  // reserve a new page at the end of the file
+  if (epid == INT_MAX) return RC_INVALID_PID;
+  pid = epid++;
+
   return 0;
 }
 
@@ -95,35 +432,91 @@ PageId PageFile::endPid() const
   return epid;
 }
 
-RC PageFile::seek(PageId pid) const
+RC PageFile::readPage(PageId pid, void* buffer, PageKind kind) const
 {
-  return (::lseek(fd, pid * PAGE_SIZE, SEEK_SET) < 0) ? RC_FILE_SEEK_FAILED : 0;
+  if (dir != NULL) return readCompressed(pid, 1, (char**) &buffer, kind);
+
+  // pread does not move the shared file offset, so concurrent
+  // readers of the same file do not interfere with each other
+  Clock::time_point start = Clock::now();
+  ssize_t done = 0;
+  while (done < pageSize) {
+    ssize_t n = ::pread(fd, (char*) buffer + done, pageSize - done, pageOffset(pid) + done);
+    if (n < 0) return RC_FILE_READ_FAILED;
+    if (n == 0) break;
+    done += n;
+  }
+  // a page past the end of the file, or cut short by it, reads as zeros
+  // beyond the end, as a page that was allocated but never written does
+  memset((char*) buffer + done, 0, pageSize - done);
+  stats->read(kind, pageSize, elapsedUsec(start));
+
+  // increase the page read count
+  readCount++;
+
+  return 0;
 }
 
-RC PageFile::write(PageId pid, const void* buffer)
+RC PageFile::readPages(PageId startPid, int count, char* buffers[], PageKind kind) const
+{
+  struct iovec iov[IOV_MAX];
+
+  if (dir != NULL) return readCompressed(startPid, count, buffers, kind);
+
+  // a single preadv takes at most IOV_MAX buffers
+  for (int i = 0; i < count; i += IOV_MAX) {
+    int n = (count - i < IOV_MAX) ? count - i : IOV_MAX;
+    for (int k = 0; k < n; k++) {
+      iov[k].iov_base = buffers[i + k];
+      iov[k].iov_len = pageSize;
+    }
+    Clock::time_point start = Clock::now();
+    ssize_t bytes = ::preadv(fd, iov, n, pageOffset(startPid + i));
+    if (bytes < 0) return RC_FILE_READ_FAILED;
+    // as in readPage(), the pages cut short by the end of the file
+    // read as zeros beyond it
+    for (int k = 0; k < n; k++) {
+      ssize_t got = bytes - (ssize_t) k * pageSize;
+      if (got >= pageSize) continue;
+      if (got < 0) got = 0;
+      memset(buffers[i + k] + got, 0, pageSize - got);
+    }
+    stats->read(kind, (long long) n * pageSize, elapsedUsec(start));
+
+    // increase the page read count
+    readCount += n;
+  }
+
+  return 0;
+}
+
+RC PageFile::writePage(PageId pid, const void* buffer, PageKind kind, long long lsn) const
 {
   RC rc;
-  if (pid < 0) return RC_INVALID_PID; 
 
-  // seek to the location of the page
-  if ((rc = seek(pid)) < 0) return rc;
+  // the log record of the page must reach the disk first
+  if (lsn > 0 && wal != NULL && (rc = wal->flush(lsn)) < 0) return rc;
 
-  // write the buffer to the disk page
-  if (::write(fd, buffer, PAGE_SIZE) < 0) return RC_FILE_WRITE_FAILED;
+  if (dir != NULL) return writeCompressed(pid, buffer, kind);
 
-  // if the page is in read cache, invalidate it
-  for (int i = 0; i < CACHE_COUNT; i++) {
-    if (readCache[i].fd == fd && readCache[i].pid == pid &&
-        readCache[i].lastAccessed != 0) {
-       readCache[i].fd = 0;
-       readCache[i].pid = 0;
-       readCache[i].lastAccessed = 0;
-       break;
+  Clock::time_point start = Clock::now();
+  int dfd = directFd;
+  if (dfd >= 0) {
+    if (::pwrite(dfd, buffer, pageSize, pageOffset(pid)) == pageSize) {
+      stats->write(kind, pageSize, elapsedUsec(start));
+      writeCount++;
+      return 0;
     }
+    // the device wants a larger alignment than the page size.
+    // give up on O_DIRECT and write through the OS page cache.
+    if (errno != EINVAL) return RC_FILE_WRITE_FAILED;
+    closeDirect();
   }
 
-  // if the written pid >= end pid, update the end pid
-  if (pid >= epid) epid = pid + 1;
+  if (::pwrite(fd, buffer, pageSize, pageOffset(pid)) < 0) {
+    return RC_FILE_WRITE_FAILED;
+  }
+  stats->write(kind, pageSize, elapsedUsec(start));
 
   // increase page write count
   writeCount++;
@@ -131,50 +524,325 @@ RC PageFile::write(PageId pid, const void* buffer)
   return 0;
 }
 
-RC PageFile::read(PageId pid, void* buffer) const
+RC PageFile::readCompressed(PageId startPid, int count, char* buffers[], PageKind kind) const
 {
   RC rc;
+  vector<PageSlot> slots(count);
+  vector<char> data;
 
-  if (pid < 0 || pid >= epid) return RC_INVALID_PID; 
+  // look up the slots of the pages. a page that was never written
+  // (e.g., reserved by allocatePage()) reads as zeros.
+  {
+    std::lock_guard<std::mutex> guard(dir->lock);
+    for (int i = 0; i < count; i++) {
+      PageId pid = startPid + i;
+      if (pid < (PageId) dir->slots.size()) slots[i] = dir->slots[pid];
+      else slots[i].length = 0;
+    }
+  }
+
+  for (int i = 0; i < count; ) {
+    if (slots[i].length == 0) {
+      memset(buffers[i], 0, pageSize);
+      i++;
+      continue;
+    }
+
+    // pages written one after another lie next to each other on disk,
+    // so a scan reads each run of them with a single pread
+    int n = 1;
+    long long bytes = slots[i].length;
+    while (i + n < count && slots[i + n].length > 0 &&
+           slots[i + n].offset == slots[i].offset + bytes) {
+      bytes += slots[i + n].length;
+      n++;
+    }
+
+    data.resize(bytes);
+    Clock::time_point start = Clock::now();
+    if (::pread(fd, &data[0], bytes, slots[i].offset) != (ssize_t) bytes) {
+      return RC_FILE_READ_FAILED;
+    }
+    stats->read(kind, bytes, elapsedUsec(start));
 
-  //
-  // if the page is in cache, read it from there
-  //
-  for (int i = 0; i < CACHE_COUNT; i++) {
-    if (readCache[i].fd == fd && readCache[i].pid == pid && 
-        readCache[i].lastAccessed != 0) {
-       memcpy(buffer, readCache[i].buffer, PAGE_SIZE);
-       readCache[i].lastAccessed = ++cacheClock;
-       return 0;
+    const char* image = &data[0];
+    for (int k = 0; k < n; k++) {
+      PageSlot& slot = slots[i + k];
+      if (slot.length == pageSize) {
+        memcpy(buffers[i + k], image, pageSize);
+      } else if ((rc = PageCodec::decompress(image, slot.length, buffers[i + k], pageSize)) < 0) {
+        return rc;
+      }
+      image += slot.length;
     }
+
+    // increase the page read count
+    readCount += n;
+    i += n;
+  }
+
+  return 0;
+}
+
+RC PageFile::writeCompressed(PageId pid, const void* buffer, PageKind kind) const
+{
+  // a page that does not shrink is stored as it is
+  vector<char> image(pageSize);
+  int length = PageCodec::compress((const char*) buffer, pageSize, &image[0], pageSize - 1);
+  const char* data = &image[0];
+  if (length < 0) {
+    length = pageSize;
+    data = (const char*) buffer;
   }
 
-  // seek to the page
-  if ((rc = seek(pid)) < 0) return rc;
-  
-  // find the cache slot to evict
-  int toEvict = 0; 
-  for (int i = 0; i < CACHE_COUNT; i++) {
-    if (readCache[i].lastAccessed == 0) {
-      toEvict = i;
-      break;
+  // reuse the old slot if the new image fits. otherwise append it.
+  PageSlot slot;
+  {
+    std::lock_guard<std::mutex> guard(dir->lock);
+    if (pid >= (PageId) dir->slots.size()) {
+      PageSlot empty = { 0, 0, 0 };
+      dir->slots.resize(pid + 1, empty);
     }
-    if (readCache[i].lastAccessed < readCache[toEvict].lastAccessed) {
-      toEvict = i;
+    slot = dir->slots[pid];
+    if (length > slot.capacity) {
+      slot.offset = dir->end;
+      slot.capacity = length;
+      dir->end += length;
     }
+    slot.length = length;
   }
-  readCache[toEvict].fd = fd;
-  readCache[toEvict].pid = pid;
-  readCache[toEvict].lastAccessed = ++cacheClock;
- 
-  // read the page to cache first and copy it to the buffer
-  if (::read(fd, readCache[toEvict].buffer, PAGE_SIZE) < 0) {
-    return RC_FILE_READ_FAILED;
+
+  Clock::time_point start = Clock::now();
+  if (::pwrite(fd, data, length, slot.offset) != length) return RC_FILE_WRITE_FAILED;
+  stats->write(kind, length, elapsedUsec(start));
+
+  // the page is found through the new slot only once it is on disk
+  {
+    std::lock_guard<std::mutex> guard(dir->lock);
+    dir->slots[pid] = slot;
+    dir->dirty = true;
   }
-  memcpy(buffer, readCache[toEvict].buffer, PAGE_SIZE);
 
-  // increase the page read count
-  readCount++;
+  // increase page write count
+  writeCount++;
+
+  return 0;
+}
+
+void PageFile::closeDirect() const
+{
+  // many threads may write back pages at once. only one closes the fd.
+  int dfd = directFd.exchange(-1);
+  if (dfd >= 0) ::close(dfd);
+}
+
+RC PageFile::write(PageId pid, const void* buffer, PageKind kind)
+{
+  RC rc;
+  if (pid < 0 || pid == INT_MAX) return RC_INVALID_PID; 
+  if (readOnly) return RC_FILE_WRITE_FAILED;
+
+  // log the new page image before the page can reach the disk
+  long long lsn = 0;
+  if (wal != NULL && (rc = wal->append(this, name, pid, buffer, pageSize, lsn)) < 0) return rc;
+
+  // update the cached copy. the disk is written when the page leaves the pool
+  if ((rc = pool->write(this, pid, buffer, kind, lsn)) < 0) return rc;
+
+  // if the written pid >= end pid, update the end pid
+  PageId end = epid;
+  while (pid >= end && !epid.compare_exchange_weak(end, pid + 1));
+
+  return 0;
+}
+
+RC PageFile::read(PageId pid, void* buffer, PageKind kind) const
+{
+  if (pid < 0 || pid >= epid) return RC_INVALID_PID; 
+
+  bool repeat = (raLast == pid);
+  readAhead(pid, kind);
+
+  // a mapped file is served from the OS page cache. like a buffer pool
+  // hit, this is not counted as a page read since no read(2) is issued.
+  if (map != NULL) {
+    memcpy(buffer, map + pageOffset(pid), pageSize);
+    stats->hit(kind);
+    return 0;
+  }
+
+  // get the page through the buffer pool
+  return pool->read(this, pid, buffer, kind, repeat);
+}
+
+RC PageFile::readRange(PageId startPid, int count, char* buffers[], PageKind kind) const
+{
+  RC rc;
+
+  if (startPid < 0 || count < 0 || startPid > epid - count) return RC_INVALID_PID;
+
+  if (map != NULL) {
+    for (int i = 0; i < count; i++) {
+      memcpy(buffers[i], map + pageOffset(startPid + i), pageSize);
+      stats->hit(kind);
+    }
+    return 0;
+  }
+
+  // copy the pages that are already cached
+  vector<bool> cached(count);
+  for (int i = 0; i < count; i++) {
+    cached[i] = pool->peek(this, startPid + i, buffers[i]);
+    if (cached[i]) stats->hit(kind);
+  }
+
+  // read each run of missing pages at once and add them to the pool
+  for (int i = 0; i < count; ) {
+    if (cached[i]) { i++; continue; }
+
+    int n = 1;
+    while (i + n < count && !cached[i + n]) n++;
+    if ((rc = readPages(startPid + i, n, buffers + i, kind)) < 0) return rc;
+
+    // a full pool only means the pages are not cached. the caller
+    // still gets them in its buffers.
+    for (int k = 0; k < n; k++) {
+      stats->miss(kind);
+      rc = pool->install(this, startPid + i + k, buffers[i + k], kind);
+      if (rc < 0 && rc != RC_CACHE_FULL) return rc;
+    }
+    i += n;
+  }
 
   return 0;
 }
+
+RC PageFile::readAsync(AsyncIO& io, PageId pid, void* buffer, AsyncRead& req,
+                       PageKind kind) const
+{
+  if (pid < 0 || pid >= epid) return RC_INVALID_PID; 
+
+  req.fd = fd;
+  req.offset = pageOffset(pid);
+  req.size = pageSize;
+  req.buffer = buffer;
+
+  // the image of a compressed page must be decompressed, so it is
+  // read right away
+  if (dir != NULL) {
+    io.finish(&req, read(pid, buffer, kind));
+    return 0;
+  }
+
+  // a cached page may be newer than the disk, so it must be taken from
+  // the pool. a mapped file is read through its descriptor instead,
+  // because touching the mapping would block until the page is in.
+  if (map == NULL && pool->peek(this, pid, buffer)) {
+    stats->hit(kind);
+    io.finish(&req, 0);
+    return 0;
+  }
+
+  // increase the page read count. the read itself is counted by
+  // completeAsync(), once its latency is known.
+  stats->miss(kind);
+  readCount++;
+
+  return io.queue(&req);
+}
+
+RC PageFile::completeAsync(AsyncRead& req, PageKind kind) const
+{
+  if (req.rc < 0 || !req.issued) return req.rc;
+
+  stats->read(kind, req.size, req.usec);
+
+  // a mapped file does not use the pool. a full pool only means the
+  // page is not cached.
+  if (map != NULL) return 0;
+  PageId pid = (PageId) ((req.offset - headerSize) / pageSize);
+  RC rc = pool->install(this, pid, req.buffer, kind);
+  return (rc == RC_CACHE_FULL) ? 0 : rc;
+}
+
+RC PageFile::pin(PageId pid, const char*& page, PageKind kind) const
+{
+  if (pid < 0 || pid >= epid) return RC_INVALID_PID; 
+
+  bool repeat = (raLast == pid);
+  readAhead(pid, kind);
+
+  // pages of a mapped file never move, so they need no pin
+  if (map != NULL) {
+    page = map + pageOffset(pid);
+    stats->hit(kind);
+    return 0;
+  }
+
+  return pool->pin(this, pid, page, kind, repeat);
+}
+
+void PageFile::unpin(PageId pid) const
+{
+  if (map != NULL) return;
+  pool->unpin(this, pid);
+}
+
+void PageFile::readAhead(PageId pid, PageKind kind) const
+{
+  PageId last = raLast.exchange(pid);
+
+  // repeated accesses to a page (e.g., to its records) change nothing
+  if (pid == last) return;
+
+  // a jump ends the sequential run
+  if (pid != last + 1) {
+    raWindow = 0;
+    raEnd = 0;
+    return;
+  }
+
+  // wait until the reader is within half a window of the prefetched pages
+  int window = raWindow;
+  if (window == 0) window = READAHEAD_MIN;
+  PageId start = raEnd;
+  if (start - pid > window / 2) return;
+  if (start <= pid) start = pid + 1;
+
+  PageId end = epid;
+  if (end - start > window) end = start + window;
+  if (end <= start) return;
+
+  // the kernel prefetches the window into the OS page cache in the
+  // background, so the reader never waits for it. the pages still reach
+  // the buffer pool one read at a time, but those reads do not wait for
+  // the disk.
+  if (map != NULL) {
+    long unit = ::sysconf(_SC_PAGESIZE);
+    size_t begin = (size_t) pageOffset(start) & ~(size_t) (unit - 1);
+    ::madvise(map + begin, (size_t) pageOffset(end) - begin, MADV_WILLNEED);
+  } else if (dir != NULL) {
+    // the images of a compressed file lie where they were written, so
+    // each run of adjacent images is advised separately
+    std::lock_guard<std::mutex> guard(dir->lock);
+    PageId p = start;
+    while (p < end && p < (PageId) dir->slots.size()) {
+      if (dir->slots[p].length == 0) { p++; continue; }
+      long long offset = dir->slots[p].offset;
+      long long bytes = dir->slots[p].length;
+      for (p++; p < end && p < (PageId) dir->slots.size() && dir->slots[p].length > 0 &&
+                dir->slots[p].offset == offset + bytes; p++) {
+        bytes += dir->slots[p].length;
+      }
+      ::posix_fadvise(fd, (off_t) offset, (off_t) bytes, POSIX_FADV_WILLNEED);
+    }
+  } else {
+    ::posix_fadvise(fd, pageOffset(start), (off_t) (end - start) * pageSize,
+                    POSIX_FADV_WILLNEED);
+  }
+  for (PageId p = start; p < end; p++) stats->prefetch(kind);
+
+  raEnd = end;
+  if (window < READAHEAD_MAX / pageSize) window *= 2;
+  raWindow = window;
+}
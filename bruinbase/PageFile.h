@@ -10,54 +10,171 @@
 #ifndef PAGEFILE_H
 #define PAGEFILE_H
 
+#include <atomic>
+#include <cstddef>
 #include <string>
+#include <sys/types.h>
 #include "Bruinbase.h"
+#include "AsyncIO.h"
+#include "IOStats.h"
 
+/**
+ * PageId stays 32-bit, because it is stored in B+tree nodes and RecordIds
+ * on disk. With 1KB pages, this allows files of up to 2TB. Byte offsets
+ * inside a file are always computed as 64-bit off_t (see pageOffset()).
+ */
 typedef int PageId;
 
+class BufferPool;
+class WriteAheadLog;
+struct PageDirectory;
+
 /**
- * read/write a file in the unit of a page
+ * read/write a file in the unit of a page.
+ * the page size is chosen when the file is created and recorded in a
+ * header that occupies the first page-sized block of the file. the header
+ * is invisible to users of the class: page 0 is the first page after it.
+ * files without the header (created before page sizes were configurable)
+ * are read as headerless files of 1KB pages.
+ * every access is counted in the I/O statistics of the file (see
+ * IOStats) under the page kind given by the caller.
+ * read(), pin() and unpin() may be called from many threads at once on
+ * the same PageFile. open(), close() and flush() must not run
+ * concurrently with any other call on the same PageFile, except for the
+ * checkpoints of the write-ahead log.
  */
 class PageFile {
  public:
 
-  static const int PAGE_SIZE = 1024;    // the size of a page is 1KB
+  static const int PAGE_SIZE = 1024;      // the default page size is 1KB
+  static const int MIN_PAGE_SIZE = 1024;  // the smallest allowed page size
+  static const int MAX_PAGE_SIZE = 65536; // the largest allowed page size
 
   PageFile();
   PageFile(const std::string& filename, char mode);
+  ~PageFile();
 
   /**
    * open a file in read or write mode.
    * when opened in 'w' mode, if the file does not exist, it is created.
+   * when opened in 'm' mode, the file is read-only and memory-mapped.
+   * its pages are then served from the mapping instead of the buffer pool.
+   * if the file cannot be mapped (e.g., it is compressed), 'm' behaves
+   * the same as 'r'.
+   * 'b' mode is 'w' mode for bulk writes: pages written back from the
+   * buffer pool go to the disk with O_DIRECT, bypassing the OS page cache,
+   * and the file's pages are dropped from the OS cache at close().
    * @param filename[IN] the name of the file to open
-   * @param mode[IN] 'r' for read, 'w' for write
+   * @param mode[IN] 'r' for read, 'w' for write, 'm' for mapped read,
+   *   'b' for bulk write
+   * @param pageSize[IN] the page size of the file if it is created.
+   *   0 selects the default page size (see setDefaultPageSize()).
+   *   an existing file always keeps the page size in its header.
+   * @param compress[IN] if true and the file is created, its pages are
+   *   stored compressed (see PageCodec). they are compressed when they
+   *   are written back from the buffer pool and decompressed when they
+   *   are read into it. an existing file keeps its format.
    * @return error code. 0 if no error
    */
-  RC open(const std::string& filename, char mode);
+  RC open(const std::string& filename, char mode, int pageSize = 0, bool compress = false);
 
   /**
    * close the file.
+   * all dirty pages of the file are written to the disk first.
    * @return error code. 0 if no error
    */
   RC close();
+
+  /**
+   * write all dirty pages of the file in the buffer pool to the disk.
+   * the pages are written in the order of their pid.
+   * @return error code. 0 if no error
+   */
+  RC flush();
   
   /**
    * read a disk page into memory buffer.
    * @param pid[IN] the page to read
    * @param buffer[OUT] pointer to memory buffer
+   * @param kind[IN] the kind of the page, for the I/O statistics
+   * @return error code. 0 if no error
+   */
+  RC read(PageId pid, void *buffer, PageKind kind = PAGE_RECORD) const;
+
+  /**
+   * read count consecutive pages into memory buffers.
+   * cached pages are copied from the buffer pool. each run of pages
+   * missing from the pool is read with a single preadv(2) and then
+   * added to the pool.
+   * @param startPid[IN] the first page to read
+   * @param count[IN] the number of pages to read
+   * @param buffers[OUT] one memory buffer for each page.
+   *   page (startPid + i) is read into buffers[i]
+   * @param kind[IN] the kind of the pages, for the I/O statistics
    * @return error code. 0 if no error
    */
-  RC read(PageId pid, void *buffer) const;
+  RC readRange(PageId startPid, int count, char* buffers[], PageKind kind = PAGE_RECORD) const;
+
+  /**
+   * queue an asynchronous read of a disk page into a memory buffer.
+   * the read is started by io.submit() and is done when io.next()
+   * returns req, which is then passed to completeAsync(). a page cached in the buffer pool is copied right away,
+   * and req is completed without I/O.
+   * @param io[IN] the engine to run the read
+   * @param pid[IN] the page to read
+   * @param buffer[OUT] the memory buffer to read the page into
+   * @param req[OUT] the request. it must stay alive until io.next()
+   *   returns it. its tag is left for the caller.
+   * @param kind[IN] the kind of the page, for the I/O statistics
+   * @return error code. 0 if no error
+   */
+  RC readAsync(AsyncIO& io, PageId pid, void* buffer, AsyncRead& req,
+               PageKind kind = PAGE_RECORD) const;
+
+  /**
+   * finish a read queued by readAsync() once io.next() has returned it.
+   * the latency of the read is added to the I/O statistics, and the page
+   * is added to the buffer pool, so that it is not read again next time.
+   * if the page got cached in the meantime, the cached copy is newer and
+   * replaces the buffer content.
+   * @param req[IN/OUT] the completed request
+   * @param kind[IN] the kind of the page, for the I/O statistics
+   * @return error code of the read. 0 if no error
+   */
+  RC completeAsync(AsyncRead& req, PageKind kind = PAGE_RECORD) const;
+
+  /**
+   * pin a disk page and get a pointer to it without copying the page.
+   * the page is loaded into the buffer pool if needed and stays there
+   * until unpin() is called. in 'm' mode the pointer goes straight into
+   * the memory mapping. the page must not be modified through the pointer.
+   * every successful pin() must be matched by one unpin() before close().
+   * @param pid[IN] the page to pin
+   * @param page[OUT] pointer to the page content
+   * @param kind[IN] the kind of the page, for the I/O statistics
+   * @return error code. 0 if no error
+   */
+  RC pin(PageId pid, const char*& page, PageKind kind = PAGE_RECORD) const;
+
+  /**
+   * release a page pinned by pin().
+   * the pointer returned by pin() must not be used afterwards.
+   * @param pid[IN] the page to unpin
+   */
+  void unpin(PageId pid) const;
   
   /**
    * write the memory buffer to the disk page.
    * if (pid >= endPid()), the file is expanded such that
    * endPid() becomes (pid + 1).
+   * the page is kept dirty in the buffer pool and reaches the disk
+   * when it is evicted, or when flush() or close() is called.
    * @param pid[IN] page to write to
    * @param buffer[IN] the content to write
+   * @param kind[IN] the kind of the page, for the I/O statistics
    * @return error code. 0 if no error
    */
-  RC write(PageId pid, const void *buffer);
+  RC write(PageId pid, const void *buffer, PageKind kind = PAGE_RECORD);
     
   /**
    * note the +1 part. The last page id in the file is actually endPid()-1.
@@ -67,7 +184,34 @@ class PageFile {
   PageId endPid() const;
 
   /**
-   * @return the total # of disk reads
+   * get a page for new data. a new page is reserved at the end of the
+   * file, and endPid() grows by one. the content of the page is
+   * undefined until it is written.
+   * @param pid[OUT] the page to use
+   * @return error code. 0 if no error
+   */
+  RC allocatePage(PageId& pid);
+
+  /**
+   * @return the size of the pages in the file
+   */
+  int getPageSize() const { return pageSize; }
+
+  /**
+   * @return true if the pages of the file are stored compressed
+   */
+  bool isCompressed() const { return dir != NULL; }
+
+  /**
+   * get the I/O statistics of the file. they are kept by file name and
+   * add up over every time the file was opened.
+   * @return the statistics of the open file
+   */
+  const IOStats& getStats() const { return *stats; }
+
+  /**
+   * @return the total # of disk reads of all files.
+   *   see getStats() for the statistics of a single file
    */
   static int getPageReadCount()  { return readCount; }
   
@@ -76,37 +220,156 @@ class PageFile {
    */
   static int getPageWriteCount() { return writeCount; }
 
+  /**
+   * set the size of the buffer pool shared by all page files.
+   * this must be called before the first file is opened.
+   * @param size[IN] the size of the buffer pool in bytes
+   * @return error code. 0 if no error
+   */
+  static RC setCacheSize(size_t size);
+
+  /**
+   * set the page size of the files created from now on.
+   * @param size[IN] the page size. a power of two between
+   *   MIN_PAGE_SIZE and MAX_PAGE_SIZE
+   * @return error code. RC_INVALID_PAGE_SIZE if size is not allowed
+   */
+  static RC setDefaultPageSize(int size);
+
+  /**
+   * log the page writes of all files through a write-ahead log. files
+   * opened for writing afterwards append each written page to the log,
+   * and their dirty pages reach the disk only after their log records.
+   * must be called when no file is open. NULL turns logging off.
+   * @param log[IN] the open log to use
+   */
+  static void setLog(WriteAheadLog* log) { wal = log; }
+
+  /**
+   * make all page writes so far durable, as far as the sync mode of
+   * the log promises. does nothing without a log.
+   * @return error code. 0 if no error
+   */
+  static RC commit();
+
  protected:
   /**
-   * move the file cursor to the beginning of a page.
-   * this is an internal function not exposed to public.
-   * @param pid[IN] page to seek to
+   * compute the byte offset of a page in the file, skipping the header.
+   * the product is computed in 64 bits, so it does not overflow at 2GB.
+   * @param pid[IN] the page
+   * @return the offset of the page from the beginning of the file
+   */
+  off_t pageOffset(PageId pid) const
+    { return headerSize + (off_t) pid * pageSize; }
+
+  /**
+   * read a page image directly from the disk with pread(2),
+   * bypassing the buffer pool. the buffer pool calls this on a miss.
+   * the part of the page beyond the end of the file reads as zeros.
+   * @param pid[IN] page to read
+   * @param buffer[OUT] the memory buffer to read the page into
+   * @param kind[IN] the kind of the page, for the I/O statistics
+   * @return error code. RC_FILE_READ_FAILED if the read fails
+   */
+  RC readPage(PageId pid, void* buffer, PageKind kind) const;
+
+  /**
+   * read consecutive page images directly from the disk with preadv(2),
+   * bypassing the buffer pool.
+   * @param startPid[IN] the first page to read
+   * @param count[IN] the number of pages to read
+   * @param buffers[OUT] one memory buffer for each page
+   * @param kind[IN] the kind of the pages, for the I/O statistics
+   * @return error code. 0 if no error
+   */
+  RC readPages(PageId startPid, int count, char* buffers[], PageKind kind) const;
+
+  /**
+   * write a page image directly to the disk with pwrite(2),
+   * bypassing the buffer pool. the buffer pool calls this to write
+   * back dirty pages. in 'b' mode the buffer must be aligned like
+   * the buffer pool frames for the O_DIRECT write to succeed.
+   * @param pid[IN] page to write to
+   * @param buffer[IN] the content to write
+   * @param kind[IN] the kind of the page, for the I/O statistics
+   * @param lsn[IN] the LSN of the last log record of the page. the log
+   *   is flushed up to it before the page is written. 0 if not logged
    * @return error code. 0 if no error
    */
-  RC seek(PageId pid) const;
+  RC writePage(PageId pid, const void* buffer, PageKind kind, long long lsn = 0) const;
+
+  /**
+   * write the dirty pages of the file back to the disk in pid order for
+   * a checkpoint, while other threads keep reading and writing the file.
+   * the directory of a compressed file is written as well, but the file
+   * is not synced.
+   * @return error code. 0 if no error
+   */
+  RC writeBack();
+
+  friend class BufferPool;
+  friend class WriteAheadLog;
 
  private:
-  int     fd;     // file descriptor of the associated unix file
-  PageId  epid;   // (last page id + 1) of the file
-
-  //
-  // the following set of members implement LRU caching 
-  //
-  static const int CACHE_COUNT = 10;
-
-  static int cacheClock; // clock tick counter for LRU policy
-
-  // the actual cache data structure
-  static struct cacheStruct {
-    int    fd;              // file id of the cached page
-    PageId pid;             // page id of the cached page
-    int    lastAccessed;    // the last time the cached page was accessed
-                            //   (lastAccessed == 0) means that the buffer is empty
-    char buffer[PAGE_SIZE]; // the buffer used for caching
-  } readCache[CACHE_COUNT];
-
-  static int readCount;  // total # of page reads 
-  static int writeCount; // total # of page writes 
+  /**
+   * detect sequential access and prefetch the pages ahead.
+   * called on every page access. each time a sequential reader gets
+   * within half a window of the prefetched pages, the next window is
+   * requested and the window doubles, up to READAHEAD_MAX bytes.
+   * a non-sequential access resets the window. the window is advised
+   * to the kernel (posix_fadvise(), or madvise() for a memory-mapped
+   * file), which reads it in the background.
+   * @param pid[IN] the page being accessed
+   * @param kind[IN] the kind of the page, also assumed for the pages ahead
+   */
+  void readAhead(PageId pid, PageKind kind) const;
+
+  /**
+   * stop using O_DIRECT for the writes of a file in 'b' mode.
+   */
+  void closeDirect() const;
+
+  /**
+   * append the page directory of a compressed file after its pages and
+   * point the header to it. must be called with the directory lock held.
+   */
+  RC writeDirectory();
+
+  /**
+   * readPages() and writePage() of a compressed file.
+   */
+  RC readCompressed(PageId startPid, int count, char* buffers[], PageKind kind) const;
+  RC writeCompressed(PageId pid, const void* buffer, PageKind kind) const;
+
+  static const int READAHEAD_MIN = 4;           // the first window in pages
+  static const int READAHEAD_MAX = 1024 * 1024; // the largest window in bytes
+
+  int     fd;       // file descriptor of the associated unix file
+  std::atomic<PageId> epid; // (last page id + 1) of the file
+  bool    readOnly; // true if the file was opened in 'r' or 'm' mode
+  char*   map;      // the memory mapping of the file in 'm' mode. NULL otherwise
+  size_t  mapSize;  // the length of the mapping
+  int     pageSize;   // the size of a page in the file
+  int     headerSize; // the size of the file header. 0 for headerless files
+  BufferPool* pool;   // the buffer pool for pages of this size
+  IOStats* stats;     // the I/O statistics of the file
+  std::string name;   // the name of the file, for the log records
+  PageDirectory* dir; // where the pages of a compressed file are. NULL otherwise
+  bool    bulk;       // true if the file was opened in 'b' mode
+  mutable std::atomic<int> directFd; // O_DIRECT descriptor for writes. -1 if not used
+
+  // readahead state. it only steers prefetching, so concurrent
+  // readers may update it without further synchronization
+  mutable std::atomic<PageId> raLast;   // the last page accessed
+  mutable std::atomic<PageId> raEnd;    // the end of the prefetched pages
+  mutable std::atomic<int>    raWindow; // the current window in pages
+
+  static size_t cacheSize;       // the size of each buffer pool in bytes
+  static int    defaultPageSize; // the page size of newly created files
+  static WriteAheadLog* wal;     // the log of all page writes. NULL if none
+
+  static std::atomic<int> readCount;  // total # of page reads 
+  static std::atomic<int> writeCount; // total # of page writes 
 };
   
 #endif // PAGEFILE_H
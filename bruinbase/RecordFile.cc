@@ -9,9 +9,66 @@
 
 #include "Bruinbase.h"
 #include "RecordFile.h"
+#include "BloomFilter.h"
+#include <algorithm>
+#include <climits>
 #include <cstring>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
+using std::make_pair;
+using std::pair;
+using std::sort;
 using std::string;
+using std::vector;
+
+bool RecordFile::compressNewFiles = false;
+RecordFile::Format RecordFile::newFormat = RecordFile::FORMAT_FIXED;
+
+// the header page of a file in a format other than FORMAT_FIXED.
+// a page of the fixed format starts with its record count, which
+// never equals TABLE_MAGIC, so the formats can be told apart.
+struct TableHeader {
+  int magic;   // TABLE_MAGIC
+  int format;  // the format of the record pages
+  int flags;   // TABLE_CLUSTERED. 0 in files written before the flags
+};
+
+static const int TABLE_MAGIC = 0x54524242;  // "BBRT"
+static const int TABLE_CLUSTERED = 1;       // the keys never decrease in rid order
+
+// the header of a zone map file, followed by the zone of each page.
+// the zones are valid only for the end record id they were written with.
+struct ZoneMapHeader {
+  int magic;     // ZONE_MAGIC
+  int prefix;    // ZONE_PREFIX of the writer
+  RecordId end;  // the end record id of the file when the zones were written
+  int count;     // # zones
+};
+
+static const int ZONE_MAGIC = 0x4d5a4242;  // "BBZM"
+
+// read a zone map file written for the end record id. returns false if
+// the file is missing, damaged or out of date
+static bool readZoneMap(const string& name, const RecordId& end,
+                        vector<RecordFile::Zone>& zones);
+
+// the header of a key filter file, followed by the filter
+struct KeyFilterHeader {
+  int magic;     // FILTER_MAGIC
+  RecordId end;  // the end record id of the file when the filter was written
+};
+
+static const int FILTER_MAGIC = 0x46424242;  // "BBBF"
+
+// read a key filter file written for the end record id. returns false
+// if the file is missing, damaged or out of date
+static bool readKeyFilter(const string& name, const RecordId& end, BloomFilter& filter);
 
 //
 // helper functions for page manipultation
@@ -32,6 +89,82 @@ static int getRecordCount(const char* page);
 // update # records stored in the page
 static void setRecordCount(char* page, int count);
 
+//
+// helper functions for pages of the slotted format.
+// a page starts with # records and the offset of the tuple area,
+// followed by the slot directory, which grows forward. the tuples
+// grow backward from the end of the page. each slot holds the offset
+// and the length of its tuple: the key followed by the value bytes
+// without a terminating zero.
+//
+
+typedef struct {
+  unsigned short offset;  // the offset of the tuple in the page
+  unsigned short length;  // the length of the tuple in bytes
+} TupleSlot;
+
+// the size of the page header of the slotted format
+static const int SLOTTED_HEADER = 2 * sizeof(int);
+
+// make the page an empty page of the slotted or the PAX format
+static void initTuplePage(char* page, int pageSize);
+
+// check whether the page has room for a record with the value
+static bool tupleFits(const char* page, const std::string& value);
+
+// add the record after the last record of the page
+static void addTuple(char* page, int key, const std::string& value);
+
+// locate the tuple in the n'th slot of the page
+static void refTuple(const char* page, int n, int& key, ValueRef& value);
+
+//
+// helper functions for pages of the PAX format.
+// a page starts with the same header as a page of the slotted format.
+// the keys follow as a packed array of ints, so that a key predicate
+// runs over contiguous memory without touching the values. the start
+// offsets of the values follow the keys as an array of 16-bit ints.
+// the values grow backward from the end of the page, so each value
+// ends where the one before it starts. a new key moves the offset
+// array up by one key.
+//
+
+// check whether the page has room for a record with the value
+static bool paxFits(const char* page, const std::string& value);
+
+// add the record after the last record of the page
+static void addPax(char* page, int key, const std::string& value);
+
+// locate the record in the n'th slot of the page
+static void refPax(const char* page, int pageSize, int n, int& key, ValueRef& value);
+
+// find the records among the first count keys of a packed key array
+// whose key is in [min, max]. their slots are stored into sids.
+// returns # records found
+static int filterKeys(const char* keys, int count, int min, int max, int sids[]);
+
+//
+// the helper functions of the slotted and the PAX format by format
+//
+
+static bool recordFits(RecordFile::Format format, const char* page, const std::string& value)
+{
+  return (format == RecordFile::FORMAT_PAX) ? paxFits(page, value) : tupleFits(page, value);
+}
+
+static void addRecord(RecordFile::Format format, char* page, int key, const std::string& value)
+{
+  if (format == RecordFile::FORMAT_PAX) addPax(page, key, value);
+  else addTuple(page, key, value);
+}
+
+static void refRecord(RecordFile::Format format, const char* page, int pageSize,
+                      int n, int& key, ValueRef& value)
+{
+  if (format == RecordFile::FORMAT_PAX) refPax(page, pageSize, n, key, value);
+  else refTuple(page, n, key, value);
+}
+
 
 //
 // helper functions for RecordId manipulation
@@ -103,83 +236,396 @@ bool operator != (const RecordId& r1, const RecordId& r2)
 }
 
 
+// compute # record slots in a page of the given size
+static int recordsPerPageOf(int pageSize)
+{
+  // the first four bytes in the page is used to store # records in the page
+  return (pageSize - sizeof(int)) / (sizeof(int) + RecordFile::MAX_VALUE_LENGTH);
+}
+
 RecordFile::RecordFile()
 {
   erid.pid = 0;
   erid.sid = 0;
+  recordsPerPage = RECORDS_PER_PAGE;
+  format = FORMAT_FIXED;
+  firstPid = 0;
+  clustered = false;
+  hasFilter = false;
+  summariesDirty = false;
 }
 
 RecordFile::RecordFile(const string& filename, char mode)
 {
+  recordsPerPage = RECORDS_PER_PAGE;
+  format = FORMAT_FIXED;
+  firstPid = 0;
+  clustered = false;
+  hasFilter = false;
+  summariesDirty = false;
   open(filename, mode);
 }
 
+bool RecordFile::parseFormat(const string& name, Format& format)
+{
+  if (name == "fixed") format = FORMAT_FIXED;
+  else if (name == "slotted") format = FORMAT_SLOTTED;
+  else if (name == "pax") format = FORMAT_PAX;
+  else return false;
+  return true;
+}
+
 RC RecordFile::open(const string& filename, char mode)
 {
   RC   rc;
-  char page[PageFile::PAGE_SIZE];
 
   // open the page file
-  if ((rc = pf.open(filename, mode)) < 0) return rc;
+  if ((rc = pf.open(filename, mode, 0, compressNewFiles)) < 0) return rc;
+  recordsPerPage = recordsPerPageOf(pf.getPageSize());
+  vector<char> page(pf.getPageSize());
+
+  // find the format of the file. a new file gets the format of new
+  // files, with a header page unless it is the fixed format.
+  bool writable = (mode != 'r' && mode != 'R' && mode != 'm' && mode != 'M');
+  format = FORMAT_FIXED;
+  firstPid = 0;
+  clustered = false;
+  if (pf.endPid() == 0) {
+    // an empty file is in key order until a key smaller than the
+    // last one is appended
+    if (writable && newFormat != FORMAT_FIXED) {
+      format = newFormat;
+      firstPid = 1;
+      clustered = true;
+      if ((rc = writeHeader()) < 0) {
+        pf.close();
+        return rc;
+      }
+    }
+  } else {
+    TableHeader header;
+    if ((rc = pf.read(0, &page[0], PAGE_META)) < 0) {
+      pf.close();
+      return rc;
+    }
+    memcpy(&header, &page[0], sizeof(header));
+    if (header.magic == TABLE_MAGIC) {
+      if (header.format != FORMAT_SLOTTED && header.format != FORMAT_PAX) {
+        // a format of a newer version
+        pf.close();
+        return RC_INVALID_FILE_FORMAT;
+      }
+      format = (Format) header.format;
+      firstPid = 1;
+      clustered = (header.flags & TABLE_CLUSTERED) != 0;
+    }
+  }
   
   //
   // in the rest of this function, we set the end record id
   //
 
   // get the end pid of the file
-  erid.pid = pf.endPid();
+  erid.pid = pf.endPid() - firstPid;
 
   // if the end pid is zero, the file is empty.
-  // set the end record id to (0, 0).
+  // set the end record id to (0, 0). the zone map of an empty file
+  // is rebuilt without reading any page, so it does not fail.
   if (erid.pid == 0) {
     erid.sid = 0;
-    return 0;
+    return openSummaries(filename, writable);
   }
 
   // obtain # records in the last page to set sid of the end record id.
   // read the last page of the file and get # records in the page.
   // remeber that the id of the last page is endPid()-1 not endPid().
-  if ((rc = pf.read(--erid.pid, page)) < 0) {
+  if ((rc = pf.read(--erid.pid + firstPid, &page[0])) < 0) {
     // an error occurred during page read
     erid.pid = erid.sid = 0;
     pf.close();
     return rc;
   }
 
-  // get # records in the last page
-  erid.sid = getRecordCount(page);
-  if (erid.sid >= RECORDS_PER_PAGE) {
+  // get # records in the last page. a page of the slotted or the PAX
+  // format is not full until a record does not fit, so append() tries
+  // it first.
+  erid.sid = getRecordCount(&page[0]);
+  if (format == FORMAT_FIXED && erid.sid >= recordsPerPage) {
     // the last page is full. advance the end record id to the next page.
     erid.pid++;
     erid.sid = 0;
   }
+
+  // read the zone map and the key filter, which must match the end record id
+  if ((rc = openSummaries(filename, writable)) < 0) {
+    erid.pid = erid.sid = 0;
+    pf.close();
+    return rc;
+  }
   
   return 0;
 }
 
 RC RecordFile::close()
 {
+  // the zone map and the key filter are written for the current end record id
+  RC rc = closeSummaries();
+  RC closeRc = pf.close();
+
   erid.pid = 0;
   erid.sid = 0;
+  zones.clear();
+  keyFilter.clear();
+  hasFilter = false;
 
-  return pf.close();
+  return (rc < 0) ? rc : closeRc;
+}
+
+RC RecordFile::openSummaries(const string& filename, bool writable)
+{
+  RC   rc;
+
+  // <name>.tbl keeps its zone map in <name>.zm and its key filter in <name>.bf
+  baseName = filename;
+  if (baseName.size() > 4 && baseName.compare(baseName.size() - 4, 4, ".tbl") == 0) {
+    baseName.erase(baseName.size() - 4);
+  }
+  summariesDirty = false;
+
+  bool hasZones = readZoneMap(baseName + ".zm", erid, zones);
+  hasFilter = readKeyFilter(baseName + ".bf", erid, keyFilter);
+  if (hasZones && hasFilter) return 0;
+
+  // a summary is missing or describes other records, e.g., when a
+  // crash lost it or the records recovered from the log. a reader does
+  // without it, and a writer rebuilds both, so that they cover every
+  // record that append() adds to. the records may have been appended by
+  // a version that did not keep the key order either, so a reader does
+  // not trust it and a writer checks it.
+  if (!writable) {
+    if (!hasZones) {
+      zones.clear();
+      clustered = false;
+    }
+    if (!hasFilter) keyFilter.clear();
+    return 0;
+  }
+  zones.clear();
+  keyFilter.clear();
+  hasFilter = true;
+
+  Scanner scanner;
+  bool sorted = true;
+  int last = INT_MIN;
+  scanner.open(*this);
+  while ((rc = scanner.nextPage()) == 0) {
+    for (int i = 0; i < scanner.getCount(); i++) {
+      int key;
+      ValueRef value;
+      scanner.getRecord(i, key, value);
+      summarize(scanner.getPid(), key, value.data, value.length);
+      if (key < last) sorted = false;
+      last = key;
+    }
+  }
+  scanner.close();
+  if (rc != RC_END_OF_FILE) {
+    zones.clear();
+    keyFilter.clear();
+    hasFilter = false;
+    return rc;
+  }
+  summariesDirty = true;
+
+  if (clustered && !sorted) {
+    clustered = false;
+    if ((rc = writeHeader()) < 0) return rc;
+  }
+  return 0;
+}
+
+RC RecordFile::writeHeader()
+{
+  vector<char> page(pf.getPageSize());
+  TableHeader header;
+  header.magic = TABLE_MAGIC;
+  header.format = format;
+  header.flags = clustered ? TABLE_CLUSTERED : 0;
+  memcpy(&page[0], &header, sizeof(header));
+  return pf.write(0, &page[0], PAGE_META);
+}
+
+RC RecordFile::keepOrder(int key)
+{
+  // the last key of a clustered file is the largest key of its last page
+  if (!clustered || zones.empty() || key >= zones.back().maxKey) return 0;
+  clustered = false;
+  return writeHeader();
+}
+
+RC RecordFile::closeSummaries()
+{
+  if (!summariesDirty) return 0;
+
+  // a summary torn by a crash is detected by its size and rebuilt
+  ZoneMapHeader header;
+  header.magic = ZONE_MAGIC;
+  header.prefix = ZONE_PREFIX;
+  header.end = erid;
+  header.count = (int) zones.size();
+
+  int fd = ::open((baseName + ".zm").c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) return RC_FILE_OPEN_FAILED;
+  size_t size = sizeof(Zone) * zones.size();
+  bool ok = (::write(fd, &header, sizeof(header)) == (ssize_t) sizeof(header));
+  if (ok && size > 0) ok = (::write(fd, &zones[0], size) == (ssize_t) size);
+  if (::close(fd) < 0) ok = false;
+  if (!ok) return RC_FILE_WRITE_FAILED;
+
+  KeyFilterHeader filterHeader;
+  filterHeader.magic = FILTER_MAGIC;
+  filterHeader.end = erid;
+
+  fd = ::open((baseName + ".bf").c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) return RC_FILE_OPEN_FAILED;
+  ok = (::write(fd, &filterHeader, sizeof(filterHeader)) == (ssize_t) sizeof(filterHeader))
+    && keyFilter.write(fd) == 0;
+  if (::close(fd) < 0) ok = false;
+  if (!ok) return RC_FILE_WRITE_FAILED;
+
+  summariesDirty = false;
+  return 0;
+}
+
+void RecordFile::summarize(PageId pid, int key, const char* value, int length)
+{
+  keyFilter.add(key);
+  summariesDirty = true;
+
+  // the zones cover the pages from the first one on without a gap
+  if (pid > (PageId) zones.size()) return;
+
+  char prefix[ZONE_PREFIX];
+  memset(prefix, 0, ZONE_PREFIX);
+  memcpy(prefix, value, (length < ZONE_PREFIX) ? length : ZONE_PREFIX);
+
+  if (pid == (PageId) zones.size()) {
+    Zone zone;
+    zone.minKey = zone.maxKey = key;
+    memcpy(zone.minValue, prefix, ZONE_PREFIX);
+    memcpy(zone.maxValue, prefix, ZONE_PREFIX);
+    zones.push_back(zone);
+  } else {
+    Zone& zone = zones[pid];
+    if (key < zone.minKey) zone.minKey = key;
+    if (key > zone.maxKey) zone.maxKey = key;
+    if (memcmp(prefix, zone.minValue, ZONE_PREFIX) < 0) memcpy(zone.minValue, prefix, ZONE_PREFIX);
+    if (memcmp(prefix, zone.maxValue, ZONE_PREFIX) > 0) memcpy(zone.maxValue, prefix, ZONE_PREFIX);
+  }
+}
+
+bool RecordFile::mayContainKey(int key) const
+{
+  return !hasFilter || keyFilter.mayContain(key);
+}
+
+bool RecordFile::getZone(PageId pid, Zone& zone) const
+{
+  if (pid < 0 || pid >= (PageId) zones.size()) return false;
+  zone = zones[pid];
+  return true;
 }
 
 RC RecordFile::read(const RecordId& rid, int& key, string& value) const
 {
   RC   rc;
-  char page[PageFile::PAGE_SIZE];
+  const char* page;
   
   // check whether the rid is in the valid range
   if (rid.pid < 0 || rid.pid > erid.pid) return RC_INVALID_RID;
-  if (rid.sid < 0 || rid.sid >= RecordFile::RECORDS_PER_PAGE) return RC_INVALID_RID;
+  if (rid.sid < 0 || (format == FORMAT_FIXED && rid.sid >= recordsPerPage)) return RC_INVALID_RID;
   if (rid >= erid) return RC_INVALID_RID;
   
-  // read the page containing the record
-  if ((rc = pf.read(rid.pid, page)) < 0) return rc;
+  // pin the page containing the record, so that it is read in place
+  if ((rc = pf.pin(rid.pid + firstPid, page)) < 0) return rc;
 
   // read the record from the slot in the page
-  readSlot(page, rid.sid, key, value);
+  rc = readRecord(page, rid.sid, key, value);
+
+  pf.unpin(rid.pid + firstPid);
+
+  return rc;
+}
+
+RC RecordFile::readRecord(const char* page, int sid, int& key, string& value) const
+{
+  if (format == FORMAT_FIXED) {
+    readSlot(page, sid, key, value);
+  } else {
+    if (sid >= getRecordCount(page)) return RC_INVALID_RID;
+    ValueRef ref;
+    refRecord(format, page, pf.getPageSize(), sid, key, ref);
+    value.assign(ref.data, ref.length);
+  }
+  return 0;
+}
+
+RC RecordFile::readBatch(AsyncIO& io, const RecordId rids[], int count,
+                         int keys[], string values[]) const
+{
+  RC rc = 0;
+  vector<pair<PageId, int> > order(count);  // (page, index) of each record
+
+  // check the rids and sort the records by page, so that every page
+  // is read once and the pages are read in ascending order
+  for (int i = 0; i < count; i++) {
+    const RecordId& rid = rids[i];
+    if (rid.pid < 0 || rid.pid > erid.pid) return RC_INVALID_RID;
+    if (rid.sid < 0 || (format == FORMAT_FIXED && rid.sid >= recordsPerPage)) return RC_INVALID_RID;
+    if (rid >= erid) return RC_INVALID_RID;
+    order[i] = make_pair(rid.pid, i);
+  }
+  sort(order.begin(), order.end());
+
+  int pageSize = pf.getPageSize();
+  vector<char> pages((size_t) READ_WINDOW * pageSize);
+  vector<AsyncRead> reqs(READ_WINDOW);
+
+  // read the pages a window at a time, so that the buffer stays small
+  // however many records the batch has
+  for (int first = 0; first < count; ) {
+    // queue the reads of the next pages and start them together
+    int last = first;
+    int queued = 0;
+    for (; last < count; last++) {
+      if (last > first && order[last].first == order[last - 1].first) continue;
+      if (queued == READ_WINDOW) break;
+      char* page = &pages[(size_t) queued * pageSize];
+      if ((rc = pf.readAsync(io, order[last].first + firstPid, page, reqs[queued])) < 0) break;
+      queued++;
+    }
+    io.submit();
+
+    // wait for every queued read, even after an error, since the
+    // engine writes into our buffers until a read completes
+    for (int i = 0; i < queued; i++) {
+      AsyncRead* req = io.next(true);
+      if (req == NULL) break;
+      RC tmp = pf.completeAsync(*req);
+      if (tmp < 0 && rc == 0) rc = tmp;
+    }
+    if (rc < 0) return rc;
+
+    // read the records from the slots in the pages, in the order of rids
+    int n = -1;
+    for (int i = first; i < last; i++) {
+      if (i == first || order[i].first != order[i - 1].first) n++;
+      const char* page = &pages[(size_t) n * pageSize];
+      int k = order[i].second;
+      if ((rc = readRecord(page, rids[k].sid, keys[k], values[k])) < 0) return rc;
+    }
+    first = last;
+  }
 
   return 0;
 }
@@ -187,33 +633,116 @@ RC RecordFile::read(const RecordId& rid, int& key, string& value) const
 RC RecordFile::append(int key, const std::string& value, RecordId& rid)
 {
   RC   rc;
-  char page[PageFile::PAGE_SIZE];
+  vector<char> buffer(pf.getPageSize());
+  char* page = &buffer[0];
 
   // unless we are writing to the the first slot of an empty page,
-  // we have to read the page first
+  // we have to read the page first. otherwise the page stays all zeros.
   if (erid.sid > 0) {
-    if ((rc = pf.read(erid.pid, page)) < 0) return rc;
-  } else {
-    // if this is the first slot of an empty page
-    // we can simply initialize the page with zeros
-    memset(page, 0, PageFile::PAGE_SIZE);
+    if ((rc = pf.read(erid.pid + firstPid, page)) < 0) return rc;
   }
     
-  // write the record to the first empty slot 
-  writeSlot(page, erid.sid, key, value);
+  if (format == FORMAT_FIXED) {
+    // write the record to the first empty slot 
+    writeSlot(page, erid.sid, key, value);
+
+    // the first four bytes in the page stores # records in the page.
+    // update this number.
+    setRecordCount(page, erid.sid + 1);
+  } else {
+    // a value longer than a page allows is truncated, as writeSlot()
+    // does for the fixed format
+    string stored = value.substr(0, getMaxValueLength());
+    if ((rc = keepOrder(key)) < 0) return rc;
 
-  // the first four bytes in the page stores # records in the page.
-  // update this number.
-  setRecordCount(page, erid.sid + 1);
+    // the record goes to a new page if the last one has no room left
+    if (erid.sid > 0 && !recordFits(format, page, stored)) {
+      erid.pid++;
+      erid.sid = 0;
+    }
+    if (erid.sid == 0) {
+      memset(page, 0, pf.getPageSize());
+      initTuplePage(page, pf.getPageSize());
+    }
+    addRecord(format, page, key, stored);
+  }
 
   // write the page to the disk
-  if ((rc = pf.write(erid.pid, page)) < 0) return rc;
+  if ((rc = pf.write(erid.pid + firstPid, page)) < 0) return rc;
+  summarize(erid.pid, key, value.data(), (int) value.size());
     
   // we need to output the rid of the record slot
   rid = erid;
 
-  // advance the end record id by one to the next empty slot
-  ++erid;
+  // advance the end record id by one to the next empty slot.
+  // a page of the other formats is full only once a record does not fit.
+  if (format == FORMAT_FIXED) advance(erid);
+  else erid.sid++;
+
+  return 0;
+}
+
+RC RecordFile::appendBatch(const int keys[], const string values[], int count, RecordId rids[])
+{
+  RC   rc;
+  int  pageSize = pf.getPageSize();
+  vector<char> buffer(pageSize);
+  char* page = &buffer[0];
+  bool pending = false;  // true if the page has records not yet written
+  int  maxLength = getMaxValueLength();
+  string truncated;      // the stored part of a value that is too long
+
+  // continue the last page if it is partly filled
+  if (erid.sid > 0 && count > 0) {
+    if ((rc = pf.read(erid.pid + firstPid, page)) < 0) return rc;
+  }
+
+  for (int i = 0; i < count; i++) {
+    if ((rc = keepOrder(keys[i])) < 0) return rc;
+    if (format == FORMAT_FIXED) {
+      // a new page starts as all zeros
+      if (erid.sid == 0) memset(page, 0, pageSize);
+      writeSlot(page, erid.sid, keys[i], values[i]);
+      setRecordCount(page, erid.sid + 1);
+    } else {
+      // a value longer than a page allows is truncated, as writeSlot()
+      // does for the fixed format
+      const string* value = &values[i];
+      if ((int) value->size() > maxLength) {
+        truncated = value->substr(0, maxLength);
+        value = &truncated;
+      }
+
+      // write the page once the next record does not fit
+      if (erid.sid > 0 && !recordFits(format, page, *value)) {
+        if ((rc = pf.write(erid.pid + firstPid, page)) < 0) return rc;
+        erid.pid++;
+        erid.sid = 0;
+      }
+      if (erid.sid == 0) {
+        memset(page, 0, pageSize);
+        initTuplePage(page, pageSize);
+      }
+      addRecord(format, page, keys[i], *value);
+    }
+    rids[i] = erid;
+    summarize(erid.pid, keys[i], values[i].data(), (int) values[i].size());
+    pending = true;
+
+    // a full page of the fixed format is written right away
+    if (format == FORMAT_FIXED) {
+      advance(erid);
+      if (erid.sid == 0) {
+        if ((rc = pf.write(rids[i].pid + firstPid, page)) < 0) return rc;
+        pending = false;
+      }
+    } else {
+      erid.sid++;
+    }
+  }
+
+  // write the last page, which is not full yet
+  if (pending && (rc = pf.write(erid.pid + firstPid, page)) < 0) return rc;
 
   return 0;
 }
@@ -223,6 +752,193 @@ const RecordId& RecordFile::endRid() const
   return erid;
 }
 
+void RecordFile::advance(RecordId& rid) const
+{
+  int count = recordsPerPage;
+
+  // a page of the other formats holds as many records as fit into it.
+  // the count of the last page is known without reading it.
+  if (format != FORMAT_FIXED) {
+    const char* page;
+    if (rid.pid == erid.pid) {
+      count = erid.sid;
+    } else if (pf.pin(rid.pid + firstPid, page) == 0) {
+      count = getRecordCount(page);
+      pf.unpin(rid.pid + firstPid);
+    } else {
+      count = 0;
+    }
+  }
+
+  // if the end of a page is reached, move to the next page
+  if (++rid.sid >= count) {
+    rid.pid++;
+    rid.sid = 0;
+  }
+}
+
+int RecordFile::getMaxValueLength() const
+{
+  // a value must fit into an empty page with its key and slot or offset
+  if (format == FORMAT_SLOTTED) {
+    return pf.getPageSize() - SLOTTED_HEADER - sizeof(TupleSlot) - sizeof(int);
+  }
+  if (format == FORMAT_PAX) {
+    return pf.getPageSize() - SLOTTED_HEADER - sizeof(unsigned short) - sizeof(int);
+  }
+  return MAX_VALUE_LENGTH - 1;
+}
+
+RecordFile::Scanner::Scanner()
+{
+  file = NULL;
+  pid = -1;
+  page = NULL;
+  count = 0;
+  windowStart = 0;
+  windowCount = 0;
+  windowSize = 0;
+  skipped = false;
+}
+
+RecordFile::Scanner::~Scanner()
+{
+  close();
+}
+
+void RecordFile::Scanner::open(const RecordFile& file)
+{
+  close();
+  this->file = &file;
+  pid = -1;
+}
+
+void RecordFile::Scanner::close()
+{
+  file = NULL;
+  page = NULL;
+  count = 0;
+  windowCount = 0;
+  windowSize = 0;
+  skipped = false;
+}
+
+RC RecordFile::Scanner::nextPage()
+{
+  RC rc;
+  if (file == NULL) return RC_END_OF_FILE;
+  page = NULL;
+  count = 0;
+
+  // the last page may be partly filled. the pages after the end
+  // record id hold no records.
+  const RecordId& end = file->erid;
+  if (pid + 1 > end.pid || (pid + 1 == end.pid && end.sid == 0)) return RC_END_OF_FILE;
+  pid++;
+
+  if (pid < windowStart || pid >= windowStart + windowCount) {
+    if ((rc = readWindow()) < 0) return rc;
+  }
+  page = &window[(size_t) (pid - windowStart) * file->pf.getPageSize()];
+  count = (pid == end.pid) ? end.sid : getRecordCount(page);
+  if (file->format == FORMAT_FIXED && count > file->recordsPerPage) count = file->recordsPerPage;
+
+  return 0;
+}
+
+RC RecordFile::Scanner::readWindow()
+{
+  RC rc;
+  int pageSize = file->pf.getPageSize();
+  int limit = SCAN_WINDOW / pageSize;
+  if (limit < 1) limit = 1;
+
+  // grow the window while the pages are read in order. after a skip,
+  // start over with one page, so that the pages the zones rule out
+  // are not read.
+  if (windowSize == 0 || skipped) windowSize = 1;
+  else if (windowSize < limit) windowSize = (2 * windowSize < limit) ? 2 * windowSize : limit;
+  skipped = false;
+
+  // the window ends at the last page holding records
+  const RecordId& end = file->erid;
+  PageId last = (end.sid > 0) ? end.pid : end.pid - 1;
+  int n = (last - pid + 1 < windowSize) ? last - pid + 1 : windowSize;
+
+  if (window.size() < (size_t) n * pageSize) window.resize((size_t) n * pageSize);
+  vector<char*> buffers(n);
+  for (int i = 0; i < n; i++) buffers[i] = &window[(size_t) i * pageSize];
+
+  windowCount = 0;
+  if ((rc = file->pf.readRange(pid + file->firstPid, n, &buffers[0])) < 0) return rc;
+  windowStart = pid;
+  windowCount = n;
+
+  return 0;
+}
+
+void RecordFile::Scanner::skipPage()
+{
+  if (file == NULL) return;
+  page = NULL;
+  count = 0;
+  skipped = true;
+
+  // nextPage() finds the end of the file if the page was the last one
+  pid++;
+}
+
+void RecordFile::Scanner::getRecord(int sid, int& key, ValueRef& value) const
+{
+  if (file->format != FORMAT_FIXED) {
+    refRecord(file->format, page, file->pf.getPageSize(), sid, key, value);
+    return;
+  }
+
+  // the value of the fixed format ends at a zero or fills its slot
+  const char* ptr = slotPtr(const_cast<char*>(page), sid);
+  memcpy(&key, ptr, sizeof(int));
+  value.data = ptr + sizeof(int);
+  value.length = (int) strnlen(value.data, RecordFile::MAX_VALUE_LENGTH);
+}
+
+int RecordFile::Scanner::getKey(int sid) const
+{
+  int key;
+  const char* ptr;
+
+  switch (file->format) {
+  case FORMAT_SLOTTED:
+    TupleSlot slot;
+    memcpy(&slot, page + SLOTTED_HEADER + sizeof(TupleSlot) * sid, sizeof(slot));
+    ptr = page + slot.offset;
+    break;
+  case FORMAT_PAX:
+    ptr = page + SLOTTED_HEADER + sizeof(int) * sid;
+    break;
+  default:
+    ptr = slotPtr(const_cast<char*>(page), sid);
+    break;
+  }
+  memcpy(&key, ptr, sizeof(int));
+  return key;
+}
+
+int RecordFile::Scanner::selectKeys(int min, int max, int sids[]) const
+{
+  // the keys of a PAX page are compared in bulk
+  if (file->format == FORMAT_PAX) {
+    return filterKeys(page + SLOTTED_HEADER, count, min, max, sids);
+  }
+
+  int n = 0;
+  for (int sid = 0; sid < count; sid++) {
+    int key = getKey(sid);
+    if (key >= min && key <= max) sids[n++] = sid;
+  }
+  return n;
+}
+
 static int getRecordCount(const char* page)
 {
   int count;
@@ -276,3 +992,172 @@ static void writeSlot(char* page, int n, int key, const std::string& value)
     strcpy(ptr + sizeof(int), value.c_str());
   }
 }
+
+static void initTuplePage(char* page, int pageSize)
+{
+  // no records, and the tuple area starts at the end of the page
+  int end = pageSize;
+  setRecordCount(page, 0);
+  memcpy(page + sizeof(int), &end, sizeof(int));
+}
+
+static bool tupleFits(const char* page, const std::string& value)
+{
+  int count, end;
+  memcpy(&count, page, sizeof(int));
+  memcpy(&end, page + sizeof(int), sizeof(int));
+
+  // the free space lies between the slot directory and the tuple area
+  int free = end - (SLOTTED_HEADER + (int) sizeof(TupleSlot) * count);
+  return (int) (sizeof(TupleSlot) + sizeof(int) + value.size()) <= free;
+}
+
+static void addTuple(char* page, int key, const std::string& value)
+{
+  int count, end;
+  memcpy(&count, page, sizeof(int));
+  memcpy(&end, page + sizeof(int), sizeof(int));
+
+  // store the tuple right before the tuple area
+  TupleSlot slot;
+  slot.length = (unsigned short) (sizeof(int) + value.size());
+  slot.offset = (unsigned short) (end - slot.length);
+  memcpy(page + slot.offset, &key, sizeof(int));
+  memcpy(page + slot.offset + sizeof(int), value.data(), value.size());
+
+  // add its slot to the directory
+  memcpy(page + SLOTTED_HEADER + sizeof(TupleSlot) * count, &slot, sizeof(slot));
+  end = slot.offset;
+  count++;
+  memcpy(page, &count, sizeof(int));
+  memcpy(page + sizeof(int), &end, sizeof(int));
+}
+
+static void refTuple(const char* page, int n, int& key, ValueRef& value)
+{
+  TupleSlot slot;
+  memcpy(&slot, page + SLOTTED_HEADER + sizeof(TupleSlot) * n, sizeof(slot));
+
+  // the key is followed by the value bytes
+  memcpy(&key, page + slot.offset, sizeof(int));
+  value.data = page + slot.offset + sizeof(int);
+  value.length = slot.length - sizeof(int);
+}
+
+static bool paxFits(const char* page, const std::string& value)
+{
+  int count, end;
+  memcpy(&count, page, sizeof(int));
+  memcpy(&end, page + sizeof(int), sizeof(int));
+
+  // the free space lies between the offset array and the values
+  int free = end - (SLOTTED_HEADER + (int) (sizeof(int) + sizeof(unsigned short)) * count);
+  return (int) (sizeof(int) + sizeof(unsigned short) + value.size()) <= free;
+}
+
+static void addPax(char* page, int key, const std::string& value)
+{
+  int count, end;
+  memcpy(&count, page, sizeof(int));
+  memcpy(&end, page + sizeof(int), sizeof(int));
+
+  // make room for the key after the last one
+  char* keys = page + SLOTTED_HEADER;
+  char* offsets = keys + sizeof(int) * count;
+  memmove(offsets + sizeof(int), offsets, sizeof(unsigned short) * count);
+  memcpy(keys + sizeof(int) * count, &key, sizeof(int));
+  offsets += sizeof(int);
+
+  // store the value right before the other values
+  end -= (int) value.size();
+  memcpy(page + end, value.data(), value.size());
+  unsigned short start = (unsigned short) end;
+  memcpy(offsets + sizeof(unsigned short) * count, &start, sizeof(start));
+
+  count++;
+  memcpy(page, &count, sizeof(int));
+  memcpy(page + sizeof(int), &end, sizeof(int));
+}
+
+static void refPax(const char* page, int pageSize, int n, int& key, ValueRef& value)
+{
+  int count;
+  memcpy(&count, page, sizeof(int));
+  const char* keys = page + SLOTTED_HEADER;
+  const char* offsets = keys + sizeof(int) * count;
+
+  // the value ends where the value of the previous record starts
+  unsigned short start, end;
+  memcpy(&key, keys + sizeof(int) * n, sizeof(int));
+  memcpy(&start, offsets + sizeof(unsigned short) * n, sizeof(start));
+  value.data = page + start;
+  if (n == 0) {
+    value.length = pageSize - start;
+  } else {
+    memcpy(&end, offsets + sizeof(unsigned short) * (n - 1), sizeof(end));
+    value.length = end - start;
+  }
+}
+
+static int filterKeys(const char* keys, int count, int min, int max, int sids[])
+{
+  int n = 0;
+  int i = 0;
+
+#ifdef __SSE2__
+  // compare four keys at a time. a key qualifies unless it is below
+  // min or above max.
+  __m128i lo = _mm_set1_epi32(min);
+  __m128i hi = _mm_set1_epi32(max);
+  for (; i + 4 <= count; i += 4) {
+    __m128i k = _mm_loadu_si128((const __m128i*) (keys + sizeof(int) * i));
+    __m128i out = _mm_or_si128(_mm_cmplt_epi32(k, lo), _mm_cmpgt_epi32(k, hi));
+    int mask = ~_mm_movemask_ps(_mm_castsi128_ps(out)) & 0xf;
+    for (int b = 0; mask != 0; b++, mask >>= 1) {
+      if (mask & 1) sids[n++] = i + b;
+    }
+  }
+#endif
+
+  // the remaining keys, or all of them without SSE2
+  for (; i < count; i++) {
+    int key;
+    memcpy(&key, keys + sizeof(int) * i, sizeof(int));
+    if (key >= min && key <= max) sids[n++] = i;
+  }
+
+  return n;
+}
+
+static bool readZoneMap(const string& name, const RecordId& end,
+                        vector<RecordFile::Zone>& zones)
+{
+  int fd = open(name.c_str(), O_RDONLY);
+  if (fd < 0) return false;
+
+  // the map must have a zone for every page with records
+  ZoneMapHeader header;
+  bool ok = (read(fd, &header, sizeof(header)) == (ssize_t) sizeof(header))
+    && header.magic == ZONE_MAGIC && header.prefix == RecordFile::ZONE_PREFIX
+    && header.end == end && header.count == (end.sid > 0 ? end.pid + 1 : end.pid);
+  if (ok) {
+    zones.resize(header.count);
+    size_t size = sizeof(RecordFile::Zone) * zones.size();
+    if (size > 0) ok = (read(fd, &zones[0], size) == (ssize_t) size);
+  }
+  close(fd);
+  return ok;
+}
+
+static bool readKeyFilter(const string& name, const RecordId& end, BloomFilter& filter)
+{
+  int fd = open(name.c_str(), O_RDONLY);
+  if (fd < 0) return false;
+
+  KeyFilterHeader header;
+  bool ok = (read(fd, &header, sizeof(header)) == (ssize_t) sizeof(header))
+    && header.magic == FILTER_MAGIC && header.end == end
+    && filter.read(fd) == 0;
+  close(fd);
+  return ok;
+}
@@ -11,7 +11,9 @@
 #define RECORDFILE_H
 
 #include <string>
+#include <vector>
 #include "PageFile.h"
+#include "BloomFilter.h"
 
 /**
  * The data structure for pointing to a particular record in a RecordFile.
@@ -22,11 +24,23 @@ typedef struct {
   int     sid;  // slot number. the first slot is 0
 } RecordId;
 
+/**
+ * a value read in place from a page of a RecordFile. like a string_view,
+ * it does not own its bytes, which stay valid while the page is pinned
+ * or the scanner that read it stays on the page.
+ * the bytes are not terminated by a zero.
+ */
+typedef struct {
+  const char* data;  // the first byte of the value
+  int length;        // the length of the value in bytes
+} ValueRef;
+
 //
 // helper functions for RecordId
 // 
 
-// RecordId iterators
+// RecordId iterators. they assume RECORDS_PER_PAGE slots per page,
+// so use RecordFile::advance() for files with another page size.
 RecordId& operator++ (RecordId& rid);
 RecordId  operator++ (RecordId& rid, int);
 
@@ -39,15 +53,76 @@ bool operator== (const RecordId& r1, const RecordId& r2);
 bool operator!= (const RecordId& r1, const RecordId& r2);
 
 /**
- * read/write a record to a file
+ * read/write a record to a file.
+ * the records are stored in one of two page formats:
+ * - FORMAT_FIXED: every page has the same number of fixed-size slots of
+ *   a key and a zero-terminated value of at most MAX_VALUE_LENGTH - 1
+ *   bytes. longer values are truncated.
+ * - FORMAT_SLOTTED: a page has a slot directory and variable-length
+ *   records, so a page holds as many records as fit, and a value may be
+ *   as long as an empty page allows (see getMaxValueLength()). longer
+ *   values are truncated to that length.
+ * - FORMAT_PAX: like FORMAT_SLOTTED, but a page keeps the keys of its
+ *   records in one packed array, apart from the values. a predicate on
+ *   the key reads only the keys (see Scanner::selectKeys()), and the
+ *   values are touched only for the records that qualify.
+ * a file in a format other than FORMAT_FIXED starts with a header page
+ * that records the format. the header is invisible to users of the
+ * class: records on page 0 are on the first page after it. files
+ * without the header (created before the slotted format existed) are
+ * in the fixed format.
+ *
+ * the file keeps two summaries of its records in sidecar files next to
+ * it. the zone map (<name>.zm for <name>.tbl) holds the range of the
+ * keys and of the value prefixes of each page. a scan skips the pages
+ * whose range cannot satisfy its conditions without reading them (see
+ * getZone()). the key filter (<name>.bf) is a bloom filter of all keys,
+ * which answers most lookups of a missing key without reading a page
+ * (see mayContainKey()). the summaries are written when the file is
+ * closed, and rebuilt from the pages when a file opened for writing
+ * finds one missing or out of date, e.g., after a crash.
+ *
+ * a new file in a format with a header page is marked clustered until
+ * a record with a key smaller than the last one is appended, so a file
+ * appended in key order is known to be sorted (see isClustered()).
  */
 class RecordFile {
  public:
 
-  // maximum length of the value field
+  /**
+   * the page format of a record file
+   */
+  enum Format {
+    FORMAT_FIXED = 1,   // fixed-size slots of MAX_VALUE_LENGTH bytes
+    FORMAT_SLOTTED = 2, // slot directory and variable-length records
+    FORMAT_PAX = 3      // a key array and variable-length values
+  };
+
+  // maximum length of the value field in the fixed format
   static const int MAX_VALUE_LENGTH = 100;  
 
-  // number of record slots per page
+  // number of pages readBatch() reads at the same time
+  static const int READ_WINDOW = 64;
+
+  // max # of bytes a scanner reads at a time
+  static const int SCAN_WINDOW = 128 * 1024;
+
+  // number of leading value bytes kept in a zone
+  static const int ZONE_PREFIX = 8;
+
+  /**
+   * the range of the records of a page. a value prefix is the first
+   * ZONE_PREFIX bytes of a value, padded with zeros, so that comparing
+   * prefixes with memcmp() orders the values as strcmp() does.
+   */
+  typedef struct {
+    int  minKey;                    // the smallest key in the page
+    int  maxKey;                    // the largest key in the page
+    char minValue[ZONE_PREFIX];     // the smallest value prefix in the page
+    char maxValue[ZONE_PREFIX];     // the largest value prefix in the page
+  } Zone;
+
+  // number of record slots per page of the default size in the fixed format
   static const int RECORDS_PER_PAGE = (PageFile::PAGE_SIZE - sizeof(int))/ (sizeof(int) + MAX_VALUE_LENGTH);  
     // Note that we subtract sizeof(int) from PAGE_SIZE because the first
     // four bytes in the page is used to store # records in the page.
@@ -58,8 +133,10 @@ class RecordFile {
   /**
    * open a file in read or write mode.
    * when opened in 'w' mode, if the file does not exist, it is created.
+   * 'm' opens the file read-only and memory-mapped (see PageFile::open()).
    * @param filename[IN] the name of the file to open
-   * @param mode[IN] 'r' for read, 'w' for write
+   * @param mode[IN] 'r' for read, 'w' for write, 'm' for mapped read,
+   *   'b' for bulk write (see PageFile::open())
    * @return error code. 0 if no error
    */
   RC open(const std::string& filename, char mode);
@@ -79,6 +156,23 @@ class RecordFile {
    */
   RC read(const RecordId& rid, int& key, std::string& value) const;
 
+  /**
+   * read many records at once. the records are sorted by page, and
+   * every page holding them is read once, in ascending order, however
+   * the records are spread over the batch. the pages are read
+   * asynchronously READ_WINDOW at a time, so scattered records cost
+   * about one disk wait per window instead of one per page.
+   * @param io[IN] the engine to run the page reads. it must have
+   *   no other reads outstanding
+   * @param rids[IN] the ids of the records to read
+   * @param count[IN] the number of records to read
+   * @param keys[OUT] keys[i] is the key of record rids[i]
+   * @param values[OUT] values[i] is the value of record rids[i]
+   * @return error code. 0 if no error
+   */
+  RC readBatch(AsyncIO& io, const RecordId rids[], int count,
+               int keys[], std::string values[]) const;
+
   /**
    * append a new record at the end of the file.
    * note that RecordFile does not have write() function.
@@ -90,15 +184,247 @@ class RecordFile {
    */
   RC append(int key, const std::string& value, RecordId& rid);
 
+  /**
+   * append many records at the end of the file. the pages are filled
+   * in memory and each page is written once, instead of once per record
+   * as with append().
+   * @param keys[IN] the record keys
+   * @param values[IN] the record values
+   * @param count[IN] the number of records
+   * @param rids[OUT] rids[i] is the location of the record (keys[i], values[i])
+   * @return error code. 0 if no error. after an error, the records
+   *   may be appended in part.
+   */
+  RC appendBatch(const int keys[], const std::string values[], int count, RecordId rids[]);
+
   /**
    * note the +1 part. The rid of the last record is endRid()-1.
    * @return (last record id + 1) of the RecordFile
    */
   const RecordId& endRid() const;
 
+  /**
+   * move a record id to the next slot of the file.
+   * in the slotted and the PAX format, the page of the record id is pinned
+   * to find its number of records.
+   * @param rid[IN/OUT] the record id to advance
+   */
+  void advance(RecordId& rid) const;
+
+  /**
+   * @return true if the keys of the records never decrease in record id
+   *   order, e.g., after LOAD ... CLUSTERED. a range of keys is then a
+   *   range of pages. always false in the fixed format, which has no
+   *   header page to record it
+   */
+  bool isClustered() const { return clustered; }
+
+  /**
+   * get the zone of a page from the zone map.
+   * @param pid[IN] the page, as in RecordId::pid
+   * @param zone[OUT] the range of the records in the page
+   * @return true if the zone is known. false if the page has no records
+   *   or the file was opened read-only without a valid zone map
+   */
+  bool getZone(PageId pid, Zone& zone) const;
+
+  /**
+   * check the key filter for a key.
+   * @param key[IN] the key to look up
+   * @return false if no record has the key. true if a record may have
+   *   it, or if the file was opened read-only without a valid key filter
+   */
+  bool mayContainKey(int key) const;
+
+  /**
+   * @return the number of record slots in a page of the file
+   *   in the fixed format
+   */
+  int getRecordsPerPage() const { return recordsPerPage; }
+
+  /**
+   * @return the page format of the file
+   */
+  Format getFormat() const { return format; }
+
+  /**
+   * @return the longest value append() stores without truncating it
+   */
+  int getMaxValueLength() const;
+
+  /**
+   * choose the page format of the record files created from now on.
+   * existing files keep their format.
+   * @param format[IN] the format of new files. FORMAT_FIXED by default
+   */
+  static void setFormat(Format format) { newFormat = format; }
+
+  /**
+   * parse the name of a page format.
+   * @param name[IN] "fixed", "slotted" or "pax"
+   * @param format[OUT] the format
+   * @return true if the name is valid
+   */
+  static bool parseFormat(const std::string& name, Format& format);
+
+  /**
+   * choose whether record files created from now on store their pages
+   * compressed (see PageFile::open()). most bytes of a slot are the zero
+   * padding of the value, so record pages compress well, and scans read
+   * a fraction of the bytes. existing files keep their format.
+   * @param on[IN] true to compress new files
+   */
+  static void setCompression(bool on) { compressNewFiles = on; }
+
+  /**
+   * read the records of a file a page at a time without copying them.
+   * the pages are read a window at a time with PageFile::readRange(),
+   * so a run of pages missing from the buffer pool takes one preadv(2).
+   * the window doubles, up to SCAN_WINDOW bytes, while the scan reads
+   * the pages in order, and starts over at one page after a skipped
+   * page. the records are handed out as keys and views into the window.
+   * the views stay valid until the scanner moves to the next page or is
+   * closed.
+   */
+  class Scanner {
+   public:
+    Scanner();
+    ~Scanner();
+
+    /**
+     * position the scanner before the first page of a file.
+     * @param file[IN] the file to scan. it must stay open until the
+     *   scanner is closed
+     */
+    void open(const RecordFile& file);
+
+    /**
+     * release the current page. must be called before the file is closed.
+     */
+    void close();
+
+    /**
+     * move to the next page of the file, reading the next window of
+     * pages if the page is not in the current one.
+     * @return error code. RC_END_OF_FILE if no page is left
+     */
+    RC nextPage();
+
+    /**
+     * move past the next page of the file without reading it, e.g.,
+     * when its zone shows that none of its records qualifies. the
+     * scanner has no current page until nextPage() is called.
+     */
+    void skipPage();
+
+    /**
+     * @return the page the scanner is on, as in RecordId::pid
+     */
+    PageId getPid() const { return pid; }
+
+    /**
+     * @return the number of records in the current page
+     */
+    int getCount() const { return count; }
+
+    /**
+     * read a record of the current page in place.
+     * @param sid[IN] the slot of the record. 0 <= sid < getCount()
+     * @param key[OUT] the record key
+     * @param value[OUT] the record value, pointing into the page
+     */
+    void getRecord(int sid, int& key, ValueRef& value) const;
+
+    /**
+     * read only the key of a record of the current page.
+     * @param sid[IN] the slot of the record. 0 <= sid < getCount()
+     * @return the record key
+     */
+    int getKey(int sid) const;
+
+    /**
+     * find the records of the current page whose key is in a range.
+     * on a page of the PAX format, the packed keys are compared with
+     * SSE2 instructions where available, four at a time.
+     * @param min[IN] the smallest key to select
+     * @param max[IN] the largest key to select
+     * @param sids[OUT] the slots of the selected records in ascending
+     *   order. must have room for getCount() slots
+     * @return the number of selected records
+     */
+    int selectKeys(int min, int max, int sids[]) const;
+
+   private:
+    const RecordFile* file; // the file being scanned. NULL if closed
+    PageId pid;             // the current page. -1 before the first page
+    const char* page;       // the current page in the window. NULL if none
+    int count;              // # records in the current page
+    std::vector<char> window; // the pages read at once
+    PageId windowStart;     // the first page in the window
+    int windowCount;        // # pages in the window
+    int windowSize;         // # pages the last window was meant to hold
+    bool skipped;           // true if a page was skipped since the last window
+
+    RC readWindow();
+  };
+
  private:
+  static bool compressNewFiles; // true if new files are compressed
+  static Format newFormat;      // the format of new files
+
   PageFile pf;     // the PageFile used to store the records
   RecordId erid;   // the last record id of the file + 1
+  int recordsPerPage; // # record slots per page, set by the page size
+  Format format;   // the page format of the file
+  PageId firstPid; // the page holding the records of page 0. 1 if the
+                   // file has a header page, 0 otherwise
+  bool clustered;  // true if the keys never decrease in record id order
+
+  std::string baseName;    // the name of the file without .tbl, for the summaries
+  std::vector<Zone> zones; // the zone of each page with records
+  BloomFilter keyFilter;   // the keys of all records
+  bool hasFilter;          // false if the key filter is not valid
+  bool summariesDirty;     // true if zones or keyFilter changed since they were read
+
+  /**
+   * read the zone map and the key filter of the file. if one is missing
+   * or does not match the end record id, both are rebuilt from the pages
+   * when the file is writable, and the missing one is dropped otherwise.
+   * @return error code. 0 if no error
+   */
+  RC openSummaries(const std::string& filename, bool writable);
+
+  /**
+   * write the zone map and the key filter if they changed.
+   * @return error code. 0 if no error
+   */
+  RC closeSummaries();
+
+  /**
+   * write the header page with the format and the flags of the file.
+   * @return error code. 0 if no error
+   */
+  RC writeHeader();
+
+  /**
+   * clear the clustered flag before a record with the key is appended,
+   * if the key is smaller than the last key of the file.
+   * @return error code. 0 if no error
+   */
+  RC keepOrder(int key);
+
+  /**
+   * add a new record to the summaries: its key to the key filter, and
+   * its key and value to the zone of its page. the zone of a new page
+   * is added to the end of the zone map.
+   */
+  void summarize(PageId pid, int key, const char* value, int length);
+
+  /**
+   * read the record in a slot of a page in the format of the file.
+   * @return error code. RC_INVALID_RID if the page has no such slot
+   */
+  RC readRecord(const char* page, int sid, int& key, std::string& value) const;
 };
 
 #endif // RECORDFILE_H
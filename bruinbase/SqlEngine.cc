@@ -7,6 +7,8 @@
  * @date 3/24/2008
  */
 
+#include <algorithm>
+#include <climits>
 #include <cstdio>
 #include <cstring>
 #include <cstdlib>
@@ -23,6 +25,181 @@ using namespace std;
 extern FILE* sqlin;
 int sqlparse(void);
 
+// # of records fetched together in an index range scan. their rids are
+// sorted by page, so a page holding many records of the range is read
+// once per batch
+static const unsigned FETCH_BATCH = 4096;
+
+bool SqlEngine::mappedReads = false;
+
+// # of records appended to a table together in a load
+static const unsigned LOAD_BATCH = 1024;
+
+// # of bytes of tuples a clustered load sorts in memory at a time
+static const size_t SORT_MEMORY = 64 * 1024 * 1024;
+
+// sorts the tuples of a clustered load by key. the tuples are sorted in
+// memory in runs of about SORT_MEMORY bytes. when the input needs more
+// than one run, each sorted run is spilled to a temporary file, and the
+// runs are merged while the tuples are read back. tuples with the same
+// key stay in the order they were added.
+class LoadSorter {
+  public:
+    LoadSorter();
+    ~LoadSorter();
+
+    // add a tuple. a full run is sorted and spilled
+    RC add(int key, const string& value);
+
+    // sort the last run and start handing out the tuples
+    RC finish();
+
+    // get the next tuple in key order. RC_END_OF_FILE after the last one
+    RC next(int& key, string& value);
+
+  private:
+    vector<pair<int, string> > tuples; // the run in memory
+    size_t bytes;                      // the size of the run in memory
+    unsigned pos;                      // the next tuple of the run to hand out
+    vector<FILE*> runs;                // the spilled runs
+    vector<pair<int, string> > heads;  // the next tuple of each spilled run
+    vector<bool> live;                 // false once a run is used up
+
+    RC spill();
+    static bool readTuple(FILE* file, pair<int, string>& tuple);
+};
+
+static bool keyLess(const pair<int, string>& a, const pair<int, string>& b)
+{
+    return a.first < b.first;
+}
+
+LoadSorter::LoadSorter()
+{
+    bytes = 0;
+    pos = 0;
+}
+
+LoadSorter::~LoadSorter()
+{
+    for (unsigned i = 0; i < runs.size(); i++)
+        fclose(runs[i]);
+}
+
+RC LoadSorter::add(int key, const string& value)
+{
+    tuples.push_back(make_pair(key, value));
+    bytes += sizeof(pair<int, string>) + value.size();
+    if (bytes >= SORT_MEMORY)
+        return spill();
+    return 0;
+}
+
+RC LoadSorter::spill()
+{
+    // the temporary file is deleted when it is closed
+    FILE* file = tmpfile();
+    if (file == NULL)
+        return RC_FILE_OPEN_FAILED;
+    runs.push_back(file);
+
+    stable_sort(tuples.begin(), tuples.end(), keyLess);
+    for (unsigned i = 0; i < tuples.size(); i++) {
+        int length = tuples[i].second.size();
+        if (fwrite(&tuples[i].first, sizeof(int), 1, file) != 1 ||
+            fwrite(&length, sizeof(int), 1, file) != 1 ||
+            fwrite(tuples[i].second.data(), 1, length, file) != (size_t) length)
+            return RC_FILE_WRITE_FAILED;
+    }
+    tuples.clear();
+    bytes = 0;
+    return 0;
+}
+
+RC LoadSorter::finish()
+{
+    RC rc;
+
+    // a single run is handed out from memory
+    if (runs.empty()) {
+        stable_sort(tuples.begin(), tuples.end(), keyLess);
+        pos = 0;
+        return 0;
+    }
+
+    // otherwise every run goes to a file, and the merge starts with
+    // the first tuple of each run
+    if (!tuples.empty() && (rc = spill()) < 0)
+        return rc;
+    heads.resize(runs.size());
+    live.resize(runs.size());
+    for (unsigned i = 0; i < runs.size(); i++) {
+        if (fflush(runs[i]) != 0 || fseek(runs[i], 0, SEEK_SET) != 0)
+            return RC_FILE_SEEK_FAILED;
+        live[i] = readTuple(runs[i], heads[i]);
+    }
+    return 0;
+}
+
+RC LoadSorter::next(int& key, string& value)
+{
+    if (runs.empty()) {
+        if (pos == tuples.size())
+            return RC_END_OF_FILE;
+        key = tuples[pos].first;
+        value = tuples[pos].second;
+        pos++;
+        return 0;
+    }
+
+    // take the smallest head. the earlier run wins a tie, since it
+    // holds the tuples added first
+    int min = -1;
+    for (unsigned i = 0; i < runs.size(); i++) {
+        if (live[i] && (min < 0 || heads[i].first < heads[min].first))
+            min = i;
+    }
+    if (min < 0)
+        return RC_END_OF_FILE;
+    key = heads[min].first;
+    value.swap(heads[min].second);
+    live[min] = readTuple(runs[min], heads[min]);
+    return 0;
+}
+
+bool LoadSorter::readTuple(FILE* file, pair<int, string>& tuple)
+{
+    int length;
+    if (fread(&tuple.first, sizeof(int), 1, file) != 1 ||
+        fread(&length, sizeof(int), 1, file) != 1)
+        return false;
+    tuple.second.resize(length);
+    return length == 0 || fread(&tuple.second[0], 1, length, file) == (size_t) length;
+}
+
+// append a batch of tuples to a table and insert them into its index.
+// truncated counts the values the table has to cut short
+static RC appendTuples(RecordFile& rf, BTreeIndex& bpt, bool index,
+                       vector<int>& keys, vector<string>& values, int& truncated)
+{
+    RC rc;
+    vector<RecordId> rids(keys.size());
+    for (unsigned i = 0; i < values.size(); i++) {
+        if ((int) values[i].size() > rf.getMaxValueLength())
+            truncated++;
+    }
+    if ((rc = rf.appendBatch(&keys[0], &values[0], keys.size(), &rids[0])) < 0)
+        return rc;
+    if (index) {
+        for (unsigned i = 0; i < keys.size(); i++) {
+            if ((rc = bpt.insert(keys[i], rids[i])) < 0)
+                return rc;
+        }
+    }
+    keys.clear();
+    values.clear();
+    return 0;
+}
 
 RC SqlEngine::run(FILE* commandline)
 {
@@ -50,10 +227,68 @@ void initRangeSet(rangeSet &t)
     t.canEqual = 0;
 }
 
+// compare a value read in place to a string like strcmp() does
+static int compareValue(const ValueRef& value, const char* s)
+{
+    int length = strlen(s);
+    int diff = memcmp(value.data, s, value.length < length ? value.length : length);
+    if (diff != 0)
+        return diff;
+    return value.length - length;
+}
+
+// check whether a page may hold a tuple that meets the conditions, given
+// its zone and the range of keys the conditions allow. a value condition
+// rules out a page only if the value prefixes of the zone decide it.
+static bool zoneMayMatch(const RecordFile::Zone& zone, long long minKey, long long maxKey,
+                         const vector<SelCond>& cond)
+{
+    if (zone.maxKey < minKey || zone.minKey > maxKey)
+        return false;
+    for (unsigned i = 0; i < cond.size(); i++) {
+        if (cond[i].attr == 1) {
+            int value = atoi(cond[i].value);
+            if (cond[i].comp == SelCond::NE && zone.minKey == value && zone.maxKey == value)
+                return false;
+            continue;
+        }
+        char prefix[RecordFile::ZONE_PREFIX];
+        strncpy(prefix, cond[i].value, RecordFile::ZONE_PREFIX);
+        int low = memcmp(zone.minValue, prefix, RecordFile::ZONE_PREFIX);
+        int high = memcmp(zone.maxValue, prefix, RecordFile::ZONE_PREFIX);
+        switch (cond[i].comp) {
+            case SelCond::EQ:
+                if (high < 0 || low > 0)
+                    return false;
+                break;
+            case SelCond::GT:
+            case SelCond::GE:
+                if (high < 0)
+                    return false;
+                break;
+            case SelCond::LT:
+            case SelCond::LE:
+                if (low > 0)
+                    return false;
+                break;
+            default:
+                break;
+        }
+    }
+    return true;
+}
+
 RC SqlEngine::select(int attr, const string& table, const vector<SelCond>& cond)
 {
     RecordFile rf;   // RecordFile containing the table
     RecordId   rid;  // record cursor for table scanning
+    RecordFile::Scanner scanner; // reads the table a page at a time in a full scan
+    vector<int> scanSids; // the records of the scanned page whose key is in range
+    int scanCount = 0; // # records in scanSids
+    int scanPos = 0; // the next record of scanSids
+    long long scanMin = INT_MIN, scanMax = INT_MAX; // the keys the conditions allow
+    RecordFile::Zone zone; // the range of the records of the next page
+    int lastPage = 0; // a scan of a clustered table reached the end of the key range
     
     BTreeIndex bpt; //B+tree
     
@@ -63,6 +298,7 @@ RC SqlEngine::select(int attr, const string& table, const vector<SelCond>& cond)
     int noresult = 0;//Search on key yields no result
     int    key;
     string value;
+    ValueRef valueRef; // the value of the tuple, in value or in a scanned page
     int    count;
     int    diff;
     
@@ -72,6 +308,16 @@ RC SqlEngine::select(int attr, const string& table, const vector<SelCond>& cond)
     int is_key_comparison = 0;
     int keyRangeSet = 0;
     
+    //Records fetched ahead in an index range scan
+    AsyncIO* io = NULL; //engine for the page reads of a batch
+    vector<RecordId> batchRids;
+    vector<int> batchKeys;
+    vector<string> batchValues;
+    unsigned batchPos = 0; //next record of the batch to use
+    int indexDone = 0; //no index entries are left in the range
+    int nextKey;
+    RecordId nextRid;
+    
     //flags to see if min or max was set on key
     rangeSet max_key;
     rangeSet min_key;
@@ -79,8 +325,9 @@ RC SqlEngine::select(int attr, const string& table, const vector<SelCond>& cond)
     initRangeSet(max_key);
     initRangeSet(min_key);
     
-    // open the index file
-    if ((hasIndex = bpt.open(table + ".idx", 'r')) < 0) {
+    // open the index file. queries only read, so with mapped reads
+    // the OS page cache serves the pages without copies
+    if ((hasIndex = bpt.open(table + ".idx", mappedReads ? 'm' : 'r')) < 0) {
         hasIndex = 0;
         bpt.close();
     }
@@ -88,11 +335,18 @@ RC SqlEngine::select(int attr, const string& table, const vector<SelCond>& cond)
         hasIndex = 1;
     
     // open the table file
-    if ((rc = rf.open(table + ".tbl", 'r')) < 0) {
+    if ((rc = rf.open(table + ".tbl", mappedReads ? 'm' : 'r')) < 0) {
         fprintf(stderr, "Error: table %s does not exist\n", table.c_str());
         return rc;
     }
     
+    // a key the key filter has never seen matches no tuple, so the
+    // query ends before the index or the table is read
+    for (unsigned i = 0; i < cond.size(); i++) {
+        if (cond[i].attr == 1 && cond[i].comp == SelCond::EQ && !rf.mayContainKey(atoi(cond[i].value)))
+            goto no_result;
+    }
+    
     //Initialize structures to optimize query
     if (hasIndex)
     {
@@ -163,6 +417,12 @@ RC SqlEngine::select(int attr, const string& table, const vector<SelCond>& cond)
         }
     }
     
+    // a clustered table stores the key range on consecutive pages. a
+    // walk over them reads each page once and in order, while the
+    // index would still be read to find every record
+    if (keyRangeSet && rf.isClustered())
+        keyRangeSet = 0;
+    
     //Set upper and lower bounds
     if (keyRangeSet)
     {
@@ -182,21 +442,119 @@ RC SqlEngine::select(int attr, const string& table, const vector<SelCond>& cond)
         if (!min_key.canEqual)
             key++;
         
-        //find first available tuple with min key
-        while((bpt.locate(key, cursor) != 0) && key<maxkeyint)
-            key++;
+        //position the cursor at the first entry with a key >= min key.
+        //the entries after it are read by walking the leaf chain
+        bpt.locate(key, cursor);
         
         //read key
-        bpt.readForward(cursor, key, rid);
+        if (bpt.readForward(cursor, key, rid) < 0)
+            goto no_result;
     }
     else//If key found, read that specific key
         bpt.readForward(cursor, key, rid);
     count = 0;
+    if (!keyFound && !keyRangeSet) {
+        // narrow the keys of a scan down to one range, so that each page
+        // selects the records in it at once. the conditions are still
+        // checked for every record selected.
+        for (unsigned i = 0; i < cond.size(); i++) {
+            if (cond[i].attr != 1)
+                continue;
+            long long value = atoi(cond[i].value);
+            switch (cond[i].comp) {
+                case SelCond::EQ:
+                    scanMin = max(scanMin, value);
+                    scanMax = min(scanMax, value);
+                    break;
+                case SelCond::GT:
+                    scanMin = max(scanMin, value + 1);
+                    break;
+                case SelCond::GE:
+                    scanMin = max(scanMin, value);
+                    break;
+                case SelCond::LT:
+                    scanMax = min(scanMax, value - 1);
+                    break;
+                case SelCond::LE:
+                    scanMax = min(scanMax, value);
+                    break;
+                default:
+                    break;
+            }
+        }
+        // the conditions on the key contradict each other
+        if (scanMin > scanMax)
+            goto no_result;
+        scanner.open(rf);
+    }
     while (rid < rf.endRid() && (keyRangeSet ? key<maxkeyint : 1)) {
         // read the tuple
-        if ((rc = rf.read(rid, key, value)) < 0) {
-            fprintf(stderr, "Error: while reading a tuple from table %s\n", table.c_str());
-            goto exit_select;
+        if (keyRangeSet) {
+            // fetch the records of the next index entries together,
+            // so that each of their pages is read once. the records
+            // come back in the order of the index
+            if (batchPos == batchRids.size()) {
+                batchRids.clear();
+                batchRids.push_back(rid);
+                while (!indexDone && batchRids.size() < FETCH_BATCH) {
+                    if (bpt.readForward(cursor, nextKey, nextRid) < 0 ||
+                        nextKey >= maxkeyint || !(nextRid < rf.endRid())) {
+                        indexDone = 1;
+                        break;
+                    }
+                    batchRids.push_back(nextRid);
+                }
+                batchKeys.resize(batchRids.size());
+                batchValues.resize(batchRids.size());
+                if (io == NULL)
+                    io = new AsyncIO();
+                if ((rc = rf.readBatch(*io, &batchRids[0], batchRids.size(), &batchKeys[0], &batchValues[0])) < 0) {
+                    fprintf(stderr, "Error: while reading a tuple from table %s\n", table.c_str());
+                    goto exit_select;
+                }
+                batchPos = 0;
+            }
+            key = batchKeys[batchPos];
+            valueRef.data = batchValues[batchPos].data();
+            valueRef.length = batchValues[batchPos].size();
+            batchPos++;
+        }
+        else if (keyFound) {
+            if ((rc = rf.read(rid, key, value)) < 0) {
+                fprintf(stderr, "Error: while reading a tuple from table %s\n", table.c_str());
+                goto exit_select;
+            }
+            valueRef.data = value.data();
+            valueRef.length = value.size();
+        }
+        else {
+            // a full scan takes the records of each page in place.
+            // only the records with a key in range are looked at.
+            while (scanPos == scanCount) {
+                if (lastPage)
+                    goto end_scan;
+                // pages whose zone rules out the conditions are not read
+                while (rf.getZone(scanner.getPid() + 1, zone) && !zoneMayMatch(zone, scanMin, scanMax, cond))
+                    scanner.skipPage();
+                if ((rc = scanner.nextPage()) < 0) {
+                    if (rc == RC_END_OF_FILE)
+                        goto end_scan;
+                    fprintf(stderr, "Error: while reading a tuple from table %s\n", table.c_str());
+                    goto exit_select;
+                }
+                scanCount = 0;
+                if (scanMin <= scanMax && scanner.getCount() > 0) {
+                    scanSids.resize(scanner.getCount());
+                    scanCount = scanner.selectKeys(scanMin, scanMax, &scanSids[0]);
+                    // in a clustered table, the pages after one that ends
+                    // above the range hold only larger keys
+                    if (rf.isClustered() && scanner.getKey(scanner.getCount() - 1) > scanMax)
+                        lastPage = 1;
+                }
+                scanPos = 0;
+            }
+            scanner.getRecord(scanSids[scanPos], key, valueRef);
+            scanPos++;
         }
         
         // check the conditions on the tuple
@@ -207,7 +565,7 @@ RC SqlEngine::select(int attr, const string& table, const vector<SelCond>& cond)
                     diff = key - atoi(cond[i].value);
                     break;
                 case 2:
-                    diff = strcmp(value.c_str(), cond[i].value);
+                    diff = compareValue(valueRef, cond[i].value);
                     break;
             }
             
@@ -244,10 +602,10 @@ RC SqlEngine::select(int attr, const string& table, const vector<SelCond>& cond)
                 fprintf(stdout, "%d\n", key);
                 break;
             case 2:  // SELECT value
-                fprintf(stdout, "%s\n", value.c_str());
+                fprintf(stdout, "%.*s\n", valueRef.length, valueRef.data);
                 break;
             case 3:  // SELECT *
-                fprintf(stdout, "%d '%s'\n", key, value.c_str());
+                fprintf(stdout, "%d '%.*s'\n", key, valueRef.length, valueRef.data);
                 break;
         }
         
@@ -256,15 +614,20 @@ RC SqlEngine::select(int attr, const string& table, const vector<SelCond>& cond)
         if (keyFound)
             break;
         if (!keyRangeSet)
-            ++rid;
+            continue; //the scanner moves on by itself
         else //condition if keyRange is set
         {
-            //Iterate until next element is found or max key is reached
-            while((bpt.locate(++key, cursor) != 0) && key<maxkeyint);
-            bpt.readForward(cursor, key, rid);
+            //move on to the next entry. the fetched ones come first
+            if (batchPos < batchRids.size()) {
+                rid = batchRids[batchPos];
+                key = batchKeys[batchPos];
+            }
+            else if (indexDone || bpt.readForward(cursor, key, rid) < 0)
+                break;
         }
         
     }
+end_scan:
     // print matching tuple count if "select count(*)"
     if (attr == 4) {
         fprintf(stdout, "%d\n", count);
@@ -275,6 +638,8 @@ RC SqlEngine::select(int attr, const string& table, const vector<SelCond>& cond)
 exit_select:
     if (attr == 4 && noresult)
         fprintf(stdout, "0\n");
+    delete io;
+    scanner.close();
     rf.close();
     return rc;
     
@@ -283,12 +648,13 @@ no_result:
     goto exit_select;
 }
 
-RC SqlEngine::load(const string& table, const string& loadfile, bool index)
+RC SqlEngine::load(const string& table, const string& loadfile, bool index, bool clustered)
 {
     int debug = 0;
     RecordFile record_file;
-    RecordId record_id;
     RC rc;
+    RC err = 0;     //the first error, returned once the files are closed
+    int truncated = 0;  //# values truncated to fit the table
     BTreeIndex bpt;
     //open file stream
     ifstream file(loadfile.c_str());
@@ -297,8 +663,9 @@ RC SqlEngine::load(const string& table, const string& loadfile, bool index)
         if (debug)
             fprintf(stderr, "Could Not Open File Error: %s\n", loadfile.c_str());
     }
-    //open table file
-    if((rc=record_file.open(table+".tbl", 'w'))<0) {
+    //open table file for a bulk write, so the loaded pages do not
+    //push other tables out of the OS page cache
+    if((rc=record_file.open(table+".tbl", 'b'))<0) {
         if (debug)
             fprintf(stderr, "Could Not Create or Write to Table: %s\n", table.c_str());
     }
@@ -309,41 +676,133 @@ RC SqlEngine::load(const string& table, const string& loadfile, bool index)
                 fprintf(stderr, "Could Not Create or Write to Index for Table: %s\n", table.c_str());
         }
     }
-    //iterate through tuples
-    while(!file.eof()) {
-        int key;
-        string line, value;
-        getline(file, line);
-        
-        if((rc=parseLoadLine(line, key, value))<0) {
-            if (debug)
-                fprintf(stderr, "Could not parse line from File: %s\n", loadfile.c_str());
-            break;
-        }
-        //ignore empty lines
-        if(key!=0||strcmp(value.c_str(), "")!=0) {
-            //write to table
-            if((rc=record_file.append(key, value, record_id))<0) {
+    //iterate through tuples. they are appended to the table in
+    //batches, so that every page of the table is written once.
+    //a clustered load sorts all tuples first
+    vector<int> keys;
+    vector<string> values;
+    LoadSorter sorter;
+    bool more = true;
+    bool failed = false;
+    while(more) {
+        //parse the next batch of tuples
+        while(keys.size() < LOAD_BATCH && !file.eof()) {
+            int key;
+            string line, value;
+            getline(file, line);
+            
+            if((rc=parseLoadLine(line, key, value))<0) {
                 if (debug)
-                    fprintf(stderr, "Could not insert key: %s\n", key);
+                    fprintf(stderr, "Could not parse line from File: %s\n", loadfile.c_str());
+                more = false;
                 break;
             }
-            if(index) {
-                if((rc=bpt.insert(key, record_id))<0) {
+            //ignore empty lines
+            if(key!=0||strcmp(value.c_str(), "")!=0) {
+                keys.push_back(key);
+                values.push_back(value);
+            }
+        }
+        if(file.eof())
+            more = false;
+        if(keys.empty())
+            continue;
+        
+        if(clustered) {
+            for(unsigned i = 0; i < keys.size() && !failed; i++) {
+                if((rc=sorter.add(keys[i], values[i]))<0) {
                     if (debug)
-                        fprintf(stderr, "Could not write to Index for Table\n");
-                    break;
+                        fprintf(stderr, "Could not sort the tuples of File: %s\n", loadfile.c_str());
+                    if(err == 0)
+                        err = rc;
+                    failed = true;
                 }
-                if (debug)
-                    printf("Inserting: %d\n", key);
+            }
+            keys.clear();
+            values.clear();
+            if(failed)
+                break;
+        }
+        //write to table and index
+        else if((rc=appendTuples(record_file, bpt, index, keys, values, truncated))<0) {
+            if (debug)
+                fprintf(stderr, "Could not insert keys %d to %d\n", keys.front(), keys.back());
+            if(err == 0)
+                err = rc;
+            failed = true;
+            break;
+        }
+    }
+    //write the sorted tuples of a clustered load in key order
+    if(clustered && !failed) {
+        int key;
+        string value;
+        if((rc=sorter.finish())>=0) {
+            while((rc=sorter.next(key, value))==0) {
+                keys.push_back(key);
+                values.push_back(value);
+                if(keys.size() == LOAD_BATCH && (rc=appendTuples(record_file, bpt, index, keys, values, truncated))<0)
+                    break;
             }
         }
+        if(rc == RC_END_OF_FILE && !keys.empty())
+            rc=appendTuples(record_file, bpt, index, keys, values, truncated);
+        if(rc<0 && rc != RC_END_OF_FILE) {
+            if (debug)
+                fprintf(stderr, "Could not write the sorted tuples to Table: %s\n", table.c_str());
+            if(err == 0)
+                err = rc;
+        }
     }
-    record_file.close();
+    if(truncated > 0)
+        fprintf(stderr, "%d values longer than %d bytes were truncated in Table: %s\n",
+                truncated, record_file.getMaxValueLength(), table.c_str());
+    if((rc=record_file.close())<0 && err == 0)
+        err = rc;
     file.close();
     if(index) {
-        bpt.close();
+        if((rc=bpt.close())<0 && err == 0)
+            err = rc;
     }
+    if(err<0)
+        return err;
+    //make the loaded table durable as far as the log sync mode promises
+    return PageFile::commit();
+}
+
+RC SqlEngine::showStats()
+{
+    vector<string> files;
+    IOStats::getFileNames(files);
+
+    fprintf(stdout, "%-16s %-8s %10s %10s %10s %10s %10s %10s %10s %10s %15s %15s\n",
+            "file", "kind", "hits", "misses", "prefetch", "evictions",
+            "reads", "writes", "read KB", "write KB", "read us p50/99", "write us p50/99");
+    for (unsigned i = 0; i < files.size(); i++) {
+        IOStats* stats = IOStats::forFile(files[i]);
+        for (int k = 0; k < PAGE_KIND_COUNT; k++) {
+            PageStats ps;
+            stats->get((PageKind) k, ps);
+            //skip the kinds of pages the file never touched
+            if (ps.hits + ps.misses + ps.prefetches + ps.writes == 0)
+                continue;
+            char rlat[32], wlat[32];
+            snprintf(rlat, sizeof(rlat), "%lld/%lld", PageStats::percentile(ps.readLatency, 50),
+                     PageStats::percentile(ps.readLatency, 99));
+            snprintf(wlat, sizeof(wlat), "%lld/%lld", PageStats::percentile(ps.writeLatency, 50),
+                     PageStats::percentile(ps.writeLatency, 99));
+            fprintf(stdout, "%-16s %-8s %10lld %10lld %10lld %10lld %10lld %10lld %10lld %10lld %15s %15s\n",
+                    files[i].c_str(), IOStats::kindName((PageKind) k), ps.hits, ps.misses,
+                    ps.prefetches, ps.evictions, ps.reads, ps.writes,
+                    ps.readBytes / 1024, ps.writeBytes / 1024, rlat, wlat);
+        }
+    }
+    return 0;
+}
+
+RC SqlEngine::resetStats()
+{
+    IOStats::resetAll();
     return 0;
 }
 
@@ -55,9 +55,27 @@ class SqlEngine {
    * @param table[IN] the table name in the LOAD command
    * @param loadfile[IN] the file name of the load file
    * @param index[IN] true if "WITH INDEX" option was specified
+   * @param clustered[IN] true if "CLUSTERED" option was specified. the
+   *   tuples are sorted by key before they are written, with an external
+   *   sort if they do not fit into memory, so that the table is stored
+   *   in key order (see RecordFile::isClustered())
    * @return error code. 0 if no error
    */
-  static RC load(const std::string& table, const std::string& loadfile, bool index);
+  static RC load(const std::string& table, const std::string& loadfile, bool index,
+                 bool clustered = false);
+
+  /**
+   * print the I/O statistics of every file used so far, one line for
+   * each kind of page the file has accessed (SHOW STATS command).
+   * @return error code. 0 if no error
+   */
+  static RC showStats();
+
+  /**
+   * clear the I/O statistics of every file (SHOW STATS RESET command).
+   * @return error code. 0 if no error
+   */
+  static RC resetStats();
 
   /**
    * parse a line from the load file into the (key, value) pair.
@@ -67,6 +85,18 @@ class SqlEngine {
    * @return error code. 0 if no error
    */
   static RC parseLoadLine(const std::string& line, int& key, std::string& value);
+
+  /**
+   * choose how queries read the table and index files.
+   * @param on[IN] true to map the files into memory ('m' mode, see
+   *   PageFile::open()), so that the OS page cache serves the pages
+   *   without copies. the pages then bypass the buffer pool and are not
+   *   counted as page reads. false by default
+   */
+  static void setMappedReads(bool on) { mappedReads = on; }
+
+ private:
+  static bool mappedReads; // true if queries map their files
 };
 
 #endif /* SQLENGINE_H */
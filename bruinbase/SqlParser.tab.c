@@ -147,18 +147,22 @@ extern int sqldebug;
     COUNT = 265,
     AND = 266,
     OR = 267,
-    COMMA = 268,
-    STAR = 269,
-    LF = 270,
-    INTEGER = 271,
-    STRING = 272,
-    ID = 273,
-    EQUAL = 274,
-    NEQUAL = 275,
-    LESS = 276,
-    LESSEQUAL = 277,
-    GREATER = 278,
-    GREATEREQUAL = 279
+    SHOW = 268,
+    STATS = 269,
+    RESET = 270,
+    CLUSTERED = 271,
+    COMMA = 272,
+    STAR = 273,
+    LF = 274,
+    INTEGER = 275,
+    STRING = 276,
+    ID = 277,
+    EQUAL = 278,
+    NEQUAL = 279,
+    LESS = 280,
+    LESSEQUAL = 281,
+    GREATER = 282,
+    GREATEREQUAL = 283
   };
 #endif
 
@@ -174,7 +178,7 @@ union YYSTYPE
   SelCond* cond;
   std::vector<SelCond>* conds;
 
-#line 178 "SqlParser.tab.c" /* yacc.c:355  */
+#line 182 "SqlParser.tab.c" /* yacc.c:355  */
 };
 # define YYSTYPE_IS_TRIVIAL 1
 # define YYSTYPE_IS_DECLARED 1
@@ -189,7 +193,7 @@ int sqlparse (void);
 
 /* Copy the second part of user declarations.  */
 
-#line 193 "SqlParser.tab.c" /* yacc.c:358  */
+#line 197 "SqlParser.tab.c" /* yacc.c:358  */
 
 #ifdef short
 # undef short
@@ -431,21 +435,21 @@ union yyalloc
 /* YYFINAL -- State number of the termination state.  */
 #define YYFINAL  2
 /* YYLAST -- Last index in YYTABLE.  */
-#define YYLAST   33
+#define YYLAST   44
 
 /* YYNTOKENS -- Number of terminals.  */
-#define YYNTOKENS  25
+#define YYNTOKENS  29
 /* YYNNTS -- Number of nonterminals.  */
-#define YYNNTS  13
+#define YYNNTS  14
 /* YYNRULES -- Number of rules.  */
-#define YYNRULES  29
+#define YYNRULES  34
 /* YYNSTATES -- Number of states.  */
-#define YYNSTATES  46
+#define YYNSTATES  56
 
 /* YYTRANSLATE[YYX] -- Symbol number corresponding to YYX as returned
    by yylex, with out-of-bounds checking.  */
 #define YYUNDEFTOK  2
-#define YYMAXUTOK   279
+#define YYMAXUTOK   283
 
 #define YYTRANSLATE(YYX)                                                \
   ((unsigned int) (YYX) <= YYMAXUTOK ? yytranslate[YYX] : YYUNDEFTOK)
@@ -481,16 +485,18 @@ static const yytype_uint8 yytranslate[] =
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     1,     2,     3,     4,
        5,     6,     7,     8,     9,    10,    11,    12,    13,    14,
-      15,    16,    17,    18,    19,    20,    21,    22,    23,    24
+      15,    16,    17,    18,    19,    20,    21,    22,    23,    24,
+      25,    26,    27,    28
 };
 
 #if YYDEBUG
   /* YYRLINE[YYN] -- Source line where rule number YYN was defined.  */
 static const yytype_uint8 yyrline[] =
 {
-       0,    52,    52,    53,    57,    58,    59,    60,    61,    65,
-      69,    74,    82,    87,    98,   104,   112,   122,   123,   124,
-     128,   136,   137,   141,   145,   146,   147,   148,   149,   150
+       0,    53,    53,    54,    58,    59,    60,    61,    62,    63,
+      67,    71,    76,    81,    86,    94,    97,   103,   108,   119,
+     125,   133,   143,   144,   145,   149,   157,   158,   162,   166,
+     167,   168,   169,   170,   171
 };
 #endif
 
@@ -500,11 +506,12 @@ static const yytype_uint8 yyrline[] =
 static const char *const yytname[] =
 {
   "$end", "error", "$undefined", "SELECT", "FROM", "WHERE", "LOAD",
-  "WITH", "INDEX", "QUIT", "COUNT", "AND", "OR", "COMMA", "STAR", "LF",
-  "INTEGER", "STRING", "ID", "EQUAL", "NEQUAL", "LESS", "LESSEQUAL",
-  "GREATER", "GREATEREQUAL", "$accept", "commands", "command",
-  "quit_command", "load_command", "select_command", "conditions",
-  "condition", "attributes", "attribute", "value", "table", "comparator", YY_NULLPTR
+  "WITH", "INDEX", "QUIT", "COUNT", "AND", "OR", "SHOW", "STATS", "RESET",
+  "CLUSTERED", "COMMA", "STAR", "LF", "INTEGER", "STRING", "ID", "EQUAL",
+  "NEQUAL", "LESS", "LESSEQUAL", "GREATER", "GREATEREQUAL", "$accept",
+  "commands", "command", "quit_command", "load_command", "show_command",
+  "select_command", "conditions", "condition", "attributes", "attribute",
+  "value", "table", "comparator", YY_NULLPTR
 };
 #endif
 
@@ -515,14 +522,14 @@ static const yytype_uint16 yytoknum[] =
 {
        0,   256,   257,   258,   259,   260,   261,   262,   263,   264,
      265,   266,   267,   268,   269,   270,   271,   272,   273,   274,
-     275,   276,   277,   278,   279
+     275,   276,   277,   278,   279,   280,   281,   282,   283
 };
 # endif
 
-#define YYPACT_NINF -14
+#define YYPACT_NINF -12
 
 #define yypact_value_is_default(Yystate) \
-  (!!((Yystate) == (-14)))
+  (!!((Yystate) == (-12)))
 
 #define YYTABLE_NINF -1
 
@@ -533,11 +540,12 @@ static const yytype_uint16 yytoknum[] =
      STATE-NUM.  */
 static const yytype_int8 yypact[] =
 {
-     -14,     0,   -14,    -5,     3,     2,   -14,   -14,   -14,   -14,
-     -14,   -14,   -14,   -14,   -14,   -14,    10,   -14,   -14,    14,
-       2,     5,    -3,     1,    11,   -14,    22,   -14,    -4,   -14,
-       4,    16,    11,   -14,   -14,   -14,   -14,   -14,   -14,   -14,
-     -12,   -14,   -14,   -14,   -14,   -14
+     -12,     0,   -12,    -1,     2,     1,   -12,     7,   -12,   -12,
+     -12,   -12,   -12,   -12,   -12,   -12,   -12,   -12,    28,   -12,
+     -12,    29,   -11,     1,    13,    16,   -12,    -3,    -2,   -12,
+      14,   -12,    30,    18,   -12,    -4,   -12,     3,     6,   -12,
+      14,   -12,   -12,   -12,   -12,   -12,   -12,   -12,   -10,    20,
+     -12,   -12,   -12,   -12,   -12,   -12
 };
 
   /* YYDEFACT[STATE-NUM] -- Default reduction number in state STATE-NUM.
@@ -545,25 +553,26 @@ static const yytype_int8 yypact[] =
      means the default is an error.  */
 static const yytype_uint8 yydefact[] =
 {
-       3,     0,     1,     0,     0,     0,     9,     8,     2,     6,
-       4,     5,     7,    19,    18,    20,     0,    17,    23,     0,
-       0,     0,     0,     0,     0,    12,     0,    10,     0,    14,
-       0,     0,     0,    13,    24,    25,    26,    28,    27,    29,
-       0,    11,    15,    21,    22,    16
+       3,     0,     1,     0,     0,     0,    10,     0,     9,     2,
+       7,     4,     6,     5,     8,    24,    23,    25,     0,    22,
+      28,     0,     0,     0,     0,     0,    15,     0,     0,    16,
+       0,    17,     0,     0,    11,     0,    19,     0,     0,    13,
+       0,    18,    29,    30,    31,    33,    32,    34,     0,     0,
+      12,    20,    26,    27,    21,    14
 };
 
   /* YYPGOTO[NTERM-NUM].  */
 static const yytype_int8 yypgoto[] =
 {
-     -14,   -14,   -14,   -14,   -14,   -14,   -14,   -13,   -14,    28,
-     -14,    13,   -14
+     -12,   -12,   -12,   -12,   -12,   -12,   -12,   -12,     4,   -12,
+      36,   -12,    19,   -12
 };
 
   /* YYDEFGOTO[NTERM-NUM].  */
 static const yytype_int8 yydefgoto[] =
 {
-      -1,     1,     8,     9,    10,    11,    28,    29,    16,    30,
-      45,    19,    40
+      -1,     1,     9,    10,    11,    12,    13,    35,    36,    18,
+      37,    54,    21,    48
 };
 
   /* YYTABLE[YYPACT[STATE-NUM]] -- What to do in state STATE-NUM.  If
@@ -571,45 +580,50 @@ static const yytype_int8 yydefgoto[] =
      number is the opposite.  If YYTABLE_NINF, syntax error.  */
 static const yytype_uint8 yytable[] =
 {
-       2,     3,    24,     4,    43,    44,     5,    32,    26,     6,
-      12,    33,    25,    13,    20,     7,    27,    14,    21,    42,
-      18,    15,    23,    34,    35,    36,    37,    38,    39,    15,
-      31,    41,    17,    22
+       2,     3,    30,     4,    25,    32,     5,    40,    26,     6,
+      52,    53,    15,     7,    33,    41,    31,    34,    14,     8,
+      16,    22,    49,    20,    17,    50,    42,    43,    44,    45,
+      46,    47,    23,    24,    28,    29,    17,    39,    38,    55,
+      19,     0,    27,     0,    51
 };
 
-static const yytype_uint8 yycheck[] =
+static const yytype_int8 yycheck[] =
 {
-       0,     1,     5,     3,    16,    17,     6,    11,     7,     9,
-      15,    15,    15,    10,     4,    15,    15,    14,     4,    32,
-      18,    18,    17,    19,    20,    21,    22,    23,    24,    18,
-       8,    15,     4,    20
+       0,     1,     5,     3,    15,     7,     6,    11,    19,     9,
+      20,    21,    10,    13,    16,    19,    19,    19,    19,    19,
+      18,    14,    16,    22,    22,    19,    23,    24,    25,    26,
+      27,    28,     4,     4,    21,    19,    22,    19,     8,    19,
+       4,    -1,    23,    -1,    40
 };
 
   /* YYSTOS[STATE-NUM] -- The (internal number of the) accessing
      symbol of state STATE-NUM.  */
 static const yytype_uint8 yystos[] =
 {
-       0,    26,     0,     1,     3,     6,     9,    15,    27,    28,
-      29,    30,    15,    10,    14,    18,    33,    34,    18,    36,
-       4,     4,    36,    17,     5,    15,     7,    15,    31,    32,
-      34,     8,    11,    15,    19,    20,    21,    22,    23,    24,
-      37,    15,    32,    16,    17,    35
+       0,    30,     0,     1,     3,     6,     9,    13,    19,    31,
+      32,    33,    34,    35,    19,    10,    18,    22,    38,    39,
+      22,    41,    14,     4,     4,    15,    19,    41,    21,    19,
+       5,    19,     7,    16,    19,    36,    37,    39,     8,    19,
+      11,    19,    23,    24,    25,    26,    27,    28,    42,    16,
+      19,    37,    20,    21,    40,    19
 };
 
   /* YYR1[YYN] -- Symbol number of symbol that rule YYN derives.  */
 static const yytype_uint8 yyr1[] =
 {
-       0,    25,    26,    26,    27,    27,    27,    27,    27,    28,
-      29,    29,    30,    30,    31,    31,    32,    33,    33,    33,
-      34,    35,    35,    36,    37,    37,    37,    37,    37,    37
+       0,    29,    30,    30,    31,    31,    31,    31,    31,    31,
+      32,    33,    33,    33,    33,    34,    34,    35,    35,    36,
+      36,    37,    38,    38,    38,    39,    40,    40,    41,    42,
+      42,    42,    42,    42,    42
 };
 
   /* YYR2[YYN] -- Number of symbols on the right hand side of rule YYN.  */
 static const yytype_uint8 yyr2[] =
 {
-       0,     2,     2,     0,     1,     1,     1,     2,     1,     1,
-       5,     7,     5,     7,     1,     3,     3,     1,     1,     1,
-       1,     1,     1,     1,     1,     1,     1,     1,     1,     1
+       0,     2,     2,     0,     1,     1,     1,     1,     2,     1,
+       1,     5,     7,     6,     8,     3,     4,     5,     7,     1,
+       3,     3,     1,     1,     1,     1,     1,     1,     1,     1,
+       1,     1,     1,     1,     1
 };
 
 
@@ -1286,67 +1300,109 @@ yyreduce:
   switch (yyn)
     {
         case 4:
-#line 57 "SqlParser.y" /* yacc.c:1646  */
+#line 58 "SqlParser.y" /* yacc.c:1646  */
     { fprintf(stdout, "Bruinbase> "); }
-#line 1292 "SqlParser.tab.c" /* yacc.c:1646  */
+#line 1306 "SqlParser.tab.c" /* yacc.c:1646  */
     break;
 
   case 5:
-#line 58 "SqlParser.y" /* yacc.c:1646  */
+#line 59 "SqlParser.y" /* yacc.c:1646  */
     { fprintf(stdout, "Bruinbase> "); }
-#line 1298 "SqlParser.tab.c" /* yacc.c:1646  */
+#line 1312 "SqlParser.tab.c" /* yacc.c:1646  */
     break;
 
-  case 7:
+  case 6:
 #line 60 "SqlParser.y" /* yacc.c:1646  */
     { fprintf(stdout, "Bruinbase> "); }
-#line 1304 "SqlParser.tab.c" /* yacc.c:1646  */
+#line 1318 "SqlParser.tab.c" /* yacc.c:1646  */
     break;
 
   case 8:
-#line 61 "SqlParser.y" /* yacc.c:1646  */
+#line 62 "SqlParser.y" /* yacc.c:1646  */
     { fprintf(stdout, "Bruinbase> "); }
-#line 1310 "SqlParser.tab.c" /* yacc.c:1646  */
+#line 1324 "SqlParser.tab.c" /* yacc.c:1646  */
     break;
 
   case 9:
-#line 65 "SqlParser.y" /* yacc.c:1646  */
-    { return 0; }
-#line 1316 "SqlParser.tab.c" /* yacc.c:1646  */
+#line 63 "SqlParser.y" /* yacc.c:1646  */
+    { fprintf(stdout, "Bruinbase> "); }
+#line 1330 "SqlParser.tab.c" /* yacc.c:1646  */
     break;
 
   case 10:
-#line 69 "SqlParser.y" /* yacc.c:1646  */
+#line 67 "SqlParser.y" /* yacc.c:1646  */
+    { return 0; }
+#line 1336 "SqlParser.tab.c" /* yacc.c:1646  */
+    break;
+
+  case 11:
+#line 71 "SqlParser.y" /* yacc.c:1646  */
     { 
 	  SqlEngine::load(std::string((yyvsp[-3].string)), std::string((yyvsp[-1].string)), false); 
 	  free((yyvsp[-3].string));
 	  free((yyvsp[-1].string));
 	}
-#line 1326 "SqlParser.tab.c" /* yacc.c:1646  */
+#line 1346 "SqlParser.tab.c" /* yacc.c:1646  */
     break;
 
-  case 11:
-#line 74 "SqlParser.y" /* yacc.c:1646  */
+  case 12:
+#line 76 "SqlParser.y" /* yacc.c:1646  */
     { 
 	  SqlEngine::load(std::string((yyvsp[-5].string)), std::string((yyvsp[-3].string)), true); 
 	  free((yyvsp[-5].string));
 	  free((yyvsp[-3].string));
 	}
-#line 1336 "SqlParser.tab.c" /* yacc.c:1646  */
+#line 1356 "SqlParser.tab.c" /* yacc.c:1646  */
     break;
 
-  case 12:
-#line 82 "SqlParser.y" /* yacc.c:1646  */
+  case 13:
+#line 81 "SqlParser.y" /* yacc.c:1646  */
+    { 
+	  SqlEngine::load(std::string((yyvsp[-4].string)), std::string((yyvsp[-2].string)), false, true); 
+	  free((yyvsp[-4].string));
+	  free((yyvsp[-2].string));
+	}
+#line 1366 "SqlParser.tab.c" /* yacc.c:1646  */
+    break;
+
+  case 14:
+#line 86 "SqlParser.y" /* yacc.c:1646  */
+    { 
+	  SqlEngine::load(std::string((yyvsp[-6].string)), std::string((yyvsp[-4].string)), true, true); 
+	  free((yyvsp[-6].string));
+	  free((yyvsp[-4].string));
+	}
+#line 1376 "SqlParser.tab.c" /* yacc.c:1646  */
+    break;
+
+  case 15:
+#line 94 "SqlParser.y" /* yacc.c:1646  */
+    {
+	  SqlEngine::showStats();
+	}
+#line 1384 "SqlParser.tab.c" /* yacc.c:1646  */
+    break;
+
+  case 16:
+#line 97 "SqlParser.y" /* yacc.c:1646  */
+    {
+	  SqlEngine::resetStats();
+	}
+#line 1392 "SqlParser.tab.c" /* yacc.c:1646  */
+    break;
+
+  case 17:
+#line 103 "SqlParser.y" /* yacc.c:1646  */
     {
    	        std::vector<SelCond> conds;
 		runSelect((yyvsp[-3].integer), (yyvsp[-1].string), conds);
 		free((yyvsp[-1].string));
 	}
-#line 1346 "SqlParser.tab.c" /* yacc.c:1646  */
+#line 1402 "SqlParser.tab.c" /* yacc.c:1646  */
     break;
 
-  case 13:
-#line 87 "SqlParser.y" /* yacc.c:1646  */
+  case 18:
+#line 108 "SqlParser.y" /* yacc.c:1646  */
     {
 	        runSelect((yyvsp[-5].integer), (yyvsp[-3].string), *(yyvsp[-1].conds));
 	  	free((yyvsp[-3].string));
@@ -1355,32 +1411,32 @@ yyreduce:
 		}
 	  	delete (yyvsp[-1].conds);
 	}
-#line 1359 "SqlParser.tab.c" /* yacc.c:1646  */
+#line 1415 "SqlParser.tab.c" /* yacc.c:1646  */
     break;
 
-  case 14:
-#line 98 "SqlParser.y" /* yacc.c:1646  */
+  case 19:
+#line 119 "SqlParser.y" /* yacc.c:1646  */
     {
 	  std::vector<SelCond>* v = new std::vector<SelCond>;
 	  v->push_back(*(yyvsp[0].cond));
 	  (yyval.conds) = v;
           delete (yyvsp[0].cond);
 	}
-#line 1370 "SqlParser.tab.c" /* yacc.c:1646  */
+#line 1426 "SqlParser.tab.c" /* yacc.c:1646  */
     break;
 
-  case 15:
-#line 104 "SqlParser.y" /* yacc.c:1646  */
+  case 20:
+#line 125 "SqlParser.y" /* yacc.c:1646  */
     {
 	  (yyvsp[-2].conds)->push_back(*(yyvsp[0].cond));
 	  (yyval.conds) = (yyvsp[-2].conds);
           delete (yyvsp[0].cond);
 	}
-#line 1380 "SqlParser.tab.c" /* yacc.c:1646  */
+#line 1436 "SqlParser.tab.c" /* yacc.c:1646  */
     break;
 
-  case 16:
-#line 112 "SqlParser.y" /* yacc.c:1646  */
+  case 21:
+#line 133 "SqlParser.y" /* yacc.c:1646  */
     { 
 	  SelCond* c = new SelCond;
 	  c->attr = (yyvsp[-2].integer);
@@ -1388,94 +1444,94 @@ yyreduce:
 	  c->value = (yyvsp[0].string);
 	  (yyval.cond) = c;
         }
-#line 1392 "SqlParser.tab.c" /* yacc.c:1646  */
+#line 1448 "SqlParser.tab.c" /* yacc.c:1646  */
     break;
 
-  case 17:
-#line 122 "SqlParser.y" /* yacc.c:1646  */
+  case 22:
+#line 143 "SqlParser.y" /* yacc.c:1646  */
     { (yyval.integer) = (yyvsp[0].integer); }
-#line 1398 "SqlParser.tab.c" /* yacc.c:1646  */
+#line 1454 "SqlParser.tab.c" /* yacc.c:1646  */
     break;
 
-  case 18:
-#line 123 "SqlParser.y" /* yacc.c:1646  */
+  case 23:
+#line 144 "SqlParser.y" /* yacc.c:1646  */
     { (yyval.integer) = 3; }
-#line 1404 "SqlParser.tab.c" /* yacc.c:1646  */
+#line 1460 "SqlParser.tab.c" /* yacc.c:1646  */
     break;
 
-  case 19:
-#line 124 "SqlParser.y" /* yacc.c:1646  */
+  case 24:
+#line 145 "SqlParser.y" /* yacc.c:1646  */
     { (yyval.integer) = 4; }
-#line 1410 "SqlParser.tab.c" /* yacc.c:1646  */
+#line 1466 "SqlParser.tab.c" /* yacc.c:1646  */
     break;
 
-  case 20:
-#line 128 "SqlParser.y" /* yacc.c:1646  */
+  case 25:
+#line 149 "SqlParser.y" /* yacc.c:1646  */
     { 
 		if (strcasecmp((yyvsp[0].string), "key") == 0) (yyval.integer)=1;
 		else if (strcasecmp((yyvsp[0].string), "value") == 0) (yyval.integer)=2;
 		else sqlerror("wrong attribute name. neither key or value");
 		free((yyvsp[0].string));
 	}
-#line 1421 "SqlParser.tab.c" /* yacc.c:1646  */
+#line 1477 "SqlParser.tab.c" /* yacc.c:1646  */
     break;
 
-  case 21:
-#line 136 "SqlParser.y" /* yacc.c:1646  */
+  case 26:
+#line 157 "SqlParser.y" /* yacc.c:1646  */
     { (yyval.string) = (yyvsp[0].string); }
-#line 1427 "SqlParser.tab.c" /* yacc.c:1646  */
+#line 1483 "SqlParser.tab.c" /* yacc.c:1646  */
     break;
 
-  case 22:
-#line 137 "SqlParser.y" /* yacc.c:1646  */
+  case 27:
+#line 158 "SqlParser.y" /* yacc.c:1646  */
     { (yyval.string) = (yyvsp[0].string); }
-#line 1433 "SqlParser.tab.c" /* yacc.c:1646  */
+#line 1489 "SqlParser.tab.c" /* yacc.c:1646  */
     break;
 
-  case 23:
-#line 141 "SqlParser.y" /* yacc.c:1646  */
+  case 28:
+#line 162 "SqlParser.y" /* yacc.c:1646  */
     { (yyval.string) = (yyvsp[0].string); }
-#line 1439 "SqlParser.tab.c" /* yacc.c:1646  */
+#line 1495 "SqlParser.tab.c" /* yacc.c:1646  */
     break;
 
-  case 24:
-#line 145 "SqlParser.y" /* yacc.c:1646  */
+  case 29:
+#line 166 "SqlParser.y" /* yacc.c:1646  */
     { (yyval.integer) = SelCond::EQ; }
-#line 1445 "SqlParser.tab.c" /* yacc.c:1646  */
+#line 1501 "SqlParser.tab.c" /* yacc.c:1646  */
     break;
 
-  case 25:
-#line 146 "SqlParser.y" /* yacc.c:1646  */
+  case 30:
+#line 167 "SqlParser.y" /* yacc.c:1646  */
     { (yyval.integer) = SelCond::NE; }
-#line 1451 "SqlParser.tab.c" /* yacc.c:1646  */
+#line 1507 "SqlParser.tab.c" /* yacc.c:1646  */
     break;
 
-  case 26:
-#line 147 "SqlParser.y" /* yacc.c:1646  */
+  case 31:
+#line 168 "SqlParser.y" /* yacc.c:1646  */
     { (yyval.integer) = SelCond::LT; }
-#line 1457 "SqlParser.tab.c" /* yacc.c:1646  */
+#line 1513 "SqlParser.tab.c" /* yacc.c:1646  */
     break;
 
-  case 27:
-#line 148 "SqlParser.y" /* yacc.c:1646  */
+  case 32:
+#line 169 "SqlParser.y" /* yacc.c:1646  */
     { (yyval.integer) = SelCond::GT; }
-#line 1463 "SqlParser.tab.c" /* yacc.c:1646  */
+#line 1519 "SqlParser.tab.c" /* yacc.c:1646  */
     break;
 
-  case 28:
-#line 149 "SqlParser.y" /* yacc.c:1646  */
+  case 33:
+#line 170 "SqlParser.y" /* yacc.c:1646  */
     { (yyval.integer) = SelCond::LE; }
-#line 1469 "SqlParser.tab.c" /* yacc.c:1646  */
+#line 1525 "SqlParser.tab.c" /* yacc.c:1646  */
     break;
 
-  case 29:
-#line 150 "SqlParser.y" /* yacc.c:1646  */
+  case 34:
+#line 171 "SqlParser.y" /* yacc.c:1646  */
     { (yyval.integer) = SelCond::GE; }
-#line 1475 "SqlParser.tab.c" /* yacc.c:1646  */
+#line 1531 "SqlParser.tab.c" /* yacc.c:1646  */
     break;
 
 
-#line 1479 "SqlParser.tab.c" /* yacc.c:1646  */
+#line 1535 "SqlParser.tab.c" /* yacc.c:1646  */
       default: break;
     }
   /* User semantic actions sometimes alter yychar, and that requires
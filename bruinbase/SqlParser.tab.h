@@ -55,18 +55,22 @@ extern int sqldebug;
     COUNT = 265,
     AND = 266,
     OR = 267,
-    COMMA = 268,
-    STAR = 269,
-    LF = 270,
-    INTEGER = 271,
-    STRING = 272,
-    ID = 273,
-    EQUAL = 274,
-    NEQUAL = 275,
-    LESS = 276,
-    LESSEQUAL = 277,
-    GREATER = 278,
-    GREATEREQUAL = 279
+    SHOW = 268,
+    STATS = 269,
+    RESET = 270,
+    CLUSTERED = 271,
+    COMMA = 272,
+    STAR = 273,
+    LF = 274,
+    INTEGER = 275,
+    STRING = 276,
+    ID = 277,
+    EQUAL = 278,
+    NEQUAL = 279,
+    LESS = 280,
+    LESSEQUAL = 281,
+    GREATER = 282,
+    GREATEREQUAL = 283
   };
 #endif
 
@@ -82,7 +86,7 @@ union YYSTYPE
   SelCond* cond;
   std::vector<SelCond>* conds;
 
-#line 86 "SqlParser.tab.h" /* yacc.c:1909  */
+#line 90 "SqlParser.tab.h" /* yacc.c:1909  */
 };
 # define YYSTYPE_IS_TRIVIAL 1
 # define YYSTYPE_IS_DECLARED 1
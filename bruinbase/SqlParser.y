@@ -38,6 +38,7 @@ static void runSelect(int attr, const char* table, const std::vector<SelCond>& c
 }
 
 %token SELECT FROM WHERE LOAD WITH INDEX QUIT COUNT AND OR 
+%token SHOW STATS RESET CLUSTERED
 %token COMMA STAR LF
 %token <string> INTEGER STRING ID
 %token EQUAL NEQUAL LESS LESSEQUAL GREATER GREATEREQUAL 
@@ -56,6 +57,7 @@ commands:
 command:
         load_command { fprintf(stdout, "Bruinbase> "); }
 	| select_command { fprintf(stdout, "Bruinbase> "); }
+	| show_command { fprintf(stdout, "Bruinbase> "); }
 	| quit_command
 	| error LF { fprintf(stdout, "Bruinbase> "); }
 	| LF { fprintf(stdout, "Bruinbase> "); }
@@ -76,6 +78,25 @@ load_command:
 	  free($2);
 	  free($4);
 	}
+	| LOAD table FROM STRING CLUSTERED LF { 
+	  SqlEngine::load(std::string($2), std::string($4), false, true); 
+	  free($2);
+	  free($4);
+	}
+	| LOAD table FROM STRING WITH INDEX CLUSTERED LF { 
+	  SqlEngine::load(std::string($2), std::string($4), true, true); 
+	  free($2);
+	  free($4);
+	}
+	;
+
+show_command:
+	SHOW STATS LF {
+	  SqlEngine::showStats();
+	}
+	| SHOW STATS RESET LF {
+	  SqlEngine::resetStats();
+	}
 	;
 
 select_command:
@@ -0,0 +1,499 @@
+/**
+ * Copyright (C) 2008 by The Regents of the University of California
+ * Redistribution of this file is permitted under the terms of the GNU
+ * Public License (GPL).
+ *
+ * @date 3/24/2008
+ */
+
+#include "WriteAheadLog.h"
+#include "PageFile.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdint.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+using std::string;
+using std::vector;
+using std::unique_lock;
+using std::mutex;
+
+// the fixed part of a log record. the file name and the page image follow.
+struct LogRecord {
+  uint32_t  magic;      // RECORD_MAGIC
+  uint32_t  checksum;   // of the record from lsn to the end of the page image
+  long long lsn;        // the LSN of the record
+  int       pid;        // the page written
+  int       pageSize;   // the size of the page image
+  int       nameLength; // the length of the file name
+};
+
+static const uint32_t RECORD_MAGIC = 0x4c574242;  // "BBWL"
+
+// FNV-1a. a torn record at the end of the log fails this check
+static uint32_t checksumOf(const char* data, size_t size)
+{
+  uint32_t h = 2166136261u;
+  for (size_t i = 0; i < size; i++) {
+    h ^= (unsigned char) data[i];
+    h *= 16777619u;
+  }
+  return h;
+}
+
+static void seal(char* record, size_t size)
+{
+  size_t skip = offsetof(LogRecord, lsn);
+  uint32_t sum = checksumOf(record + skip, size - skip);
+  memcpy(record + offsetof(LogRecord, checksum), &sum, sizeof(sum));
+}
+
+// write the pages of a file to the disk
+static RC syncFile(const string& name)
+{
+  int fd = ::open(name.c_str(), O_RDONLY);
+  if (fd < 0) return RC_FILE_OPEN_FAILED;
+  RC rc = (::fdatasync(fd) < 0) ? RC_FILE_WRITE_FAILED : 0;
+  ::close(fd);
+  return rc;
+}
+
+// make the creation and removal of the segments in the directory of the
+// log durable
+static RC syncDirectory(const string& filename)
+{
+  size_t slash = filename.rfind('/');
+  string dirName = (slash == string::npos) ? "." : filename.substr(0, slash + 1);
+  int fd = ::open(dirName.c_str(), O_RDONLY);
+  if (fd < 0) return RC_FILE_OPEN_FAILED;
+  RC rc = (::fsync(fd) < 0) ? RC_FILE_WRITE_FAILED : 0;
+  ::close(fd);
+  return rc;
+}
+
+// find the segments of a log on disk. their first LSNs are
+// returned in ascending order.
+static RC listSegments(const string& filename, vector<long long>& lsns)
+{
+  size_t slash = filename.rfind('/');
+  string dirName = (slash == string::npos) ? "." : filename.substr(0, slash + 1);
+  string prefix = ((slash == string::npos) ? filename : filename.substr(slash + 1)) + ".";
+
+  DIR* d = ::opendir(dirName.c_str());
+  if (d == NULL) return RC_FILE_OPEN_FAILED;
+  lsns.clear();
+  struct dirent* e;
+  while ((e = ::readdir(d)) != NULL) {
+    const char* suffix = e->d_name + prefix.size();
+    if (strncmp(e->d_name, prefix.c_str(), prefix.size()) != 0 || *suffix == '\0' ||
+        strspn(suffix, "0123456789") != strlen(suffix)) continue;
+    lsns.push_back(atoll(suffix));
+  }
+  ::closedir(d);
+
+  std::sort(lsns.begin(), lsns.end());
+  return 0;
+}
+
+WriteAheadLog::WriteAheadLog()
+{
+  fd = -1;
+  mode = SYNC_COMMIT;
+  interval = 0;
+  appended = written = synced = 0;
+  busy = false;
+  failed = false;
+  stopping = false;
+}
+
+WriteAheadLog::~WriteAheadLog()
+{
+  if (fd >= 0) close();
+}
+
+bool WriteAheadLog::parseSyncMode(const string& name, SyncMode& mode)
+{
+  if (name == "none") mode = SYNC_NONE;
+  else if (name == "commit") mode = SYNC_COMMIT;
+  else if (name == "delayed") mode = SYNC_DELAYED;
+  else return false;
+  return true;
+}
+
+RC WriteAheadLog::open(const string& filename, SyncMode mode, int checkpointInterval)
+{
+  RC rc;
+
+  if (fd >= 0) return RC_FILE_OPEN_FAILED;
+  this->filename = filename;
+  this->mode = mode;
+  interval = checkpointInterval;
+
+  // bring the files up to date with the log left by a crash
+  if ((rc = recover()) < 0) return rc;
+
+  appended = written = synced = 0;
+  busy = false;
+  failed = false;
+  stopping = false;
+  if ((rc = startSegment(0)) < 0) return rc;
+
+  buffer.reserve(BUFFER_SIZE);
+  if (mode == SYNC_DELAYED) syncer = std::thread(&WriteAheadLog::runSyncer, this);
+  if (interval > 0) checkpointer = std::thread(&WriteAheadLog::runCheckpointer, this);
+
+  return 0;
+}
+
+RC WriteAheadLog::close()
+{
+  RC rc, tmp;
+
+  if (fd < 0) return RC_FILE_CLOSE_FAILED;
+
+  {
+    unique_lock<mutex> guard(lock);
+    stopping = true;
+  }
+  done.notify_all();
+  if (syncer.joinable()) syncer.join();
+  if (checkpointer.joinable()) checkpointer.join();
+
+  {
+    unique_lock<mutex> guard(lock);
+    rc = writeOut(guard, appended, true);
+  }
+
+  // once the files are on disk, the log is no longer needed
+  if (rc == 0) {
+    for (std::set<string>::iterator it = files.begin(); it != files.end(); ++it) {
+      if ((tmp = syncFile(*it)) < 0) rc = tmp;
+    }
+  }
+  if (rc == 0) removeSegments(LLONG_MAX);
+  files.clear();
+  segments.clear();
+
+  if (::close(fd) < 0 && rc == 0) rc = RC_FILE_CLOSE_FAILED;
+  fd = -1;
+  return rc;
+}
+
+RC WriteAheadLog::append(const void* file, const string& filename, int pid,
+                         const void* page, int pageSize, long long& lsn)
+{
+  unique_lock<mutex> guard(lock);
+  if (fd < 0 || failed) return RC_FILE_WRITE_FAILED;
+
+  // the page has a record that is still in memory. just update it.
+  std::pair<const void*, int> key(file, pid);
+  std::map<std::pair<const void*, int>, size_t>::iterator it = pending.find(key);
+  if (it != pending.end()) {
+    char* record = &buffer[it->second];
+    LogRecord header;
+    memcpy(&header, record, sizeof(header));
+    memcpy(record + sizeof(header) + header.nameLength, page, pageSize);
+    seal(record, sizeof(header) + header.nameLength + pageSize);
+    lsn = header.lsn;
+    return 0;
+  }
+
+  // add a new record at the end of the buffer
+  size_t size = sizeof(LogRecord) + filename.size() + pageSize;
+  size_t offset = buffer.size();
+  buffer.resize(offset + size);
+  char* record = &buffer[offset];
+
+  LogRecord header;
+  memset(&header, 0, sizeof(header));
+  header.magic = RECORD_MAGIC;
+  header.lsn = appended + size;
+  header.pid = pid;
+  header.pageSize = pageSize;
+  header.nameLength = (int) filename.size();
+  memcpy(record, &header, sizeof(header));
+  memcpy(record + sizeof(header), filename.data(), filename.size());
+  memcpy(record + sizeof(header) + filename.size(), page, pageSize);
+  seal(record, size);
+
+  appended += size;
+  pending[key] = offset;
+  files.insert(filename);
+  lsn = appended;
+
+  // a full buffer goes to the OS without waiting for a commit
+  if (buffer.size() >= BUFFER_SIZE && !busy) return writeOut(guard, appended, false);
+
+  return 0;
+}
+
+RC WriteAheadLog::flush(long long lsn)
+{
+  unique_lock<mutex> guard(lock);
+  return writeOut(guard, lsn, mode != SYNC_NONE);
+}
+
+RC WriteAheadLog::commit()
+{
+  unique_lock<mutex> guard(lock);
+  return writeOut(guard, appended, mode == SYNC_COMMIT);
+}
+
+RC WriteAheadLog::writeOut(unique_lock<mutex>& guard, long long lsn, bool sync)
+{
+  for (;;) {
+    if (failed) return RC_FILE_WRITE_FAILED;
+    if ((sync ? synced : written) >= lsn) return 0;
+
+    // another thread is writing the log. when it is done, the records
+    // we need may be on disk already, or we write them with the records
+    // appended in the meantime.
+    if (busy) {
+      done.wait(guard);
+      continue;
+    }
+
+    // take the buffer and write it without holding the lock,
+    // so that other threads keep appending to a new buffer
+    busy = true;
+    vector<char> data;
+    data.swap(buffer);
+    buffer.reserve(BUFFER_SIZE);
+    pending.clear();
+    long long start = written;
+    long long end = appended;
+    int out = fd;  // the segment is not switched while busy
+    off_t offset = (off_t) (start - segments.back());
+    guard.unlock();
+
+    RC rc = 0;
+    if (!data.empty() &&
+        ::pwrite(out, &data[0], data.size(), offset) != (ssize_t) data.size()) {
+      rc = RC_FILE_WRITE_FAILED;
+    }
+    if (rc == 0 && sync && ::fdatasync(out) < 0) rc = RC_FILE_WRITE_FAILED;
+
+    guard.lock();
+    busy = false;
+    if (rc < 0) failed = true;
+    else {
+      written = end;
+      if (sync) synced = end;
+    }
+    done.notify_all();
+  }
+}
+
+RC WriteAheadLog::checkpoint()
+{
+  std::lock_guard<mutex> one(checkpointLock);
+  RC rc = 0, tmp;
+  long long start;
+  std::set<string> names;
+
+  // write out the records so far, and log the writes from now on in a
+  // new segment. the old segment must be durable first, so that the log
+  // never has a hole after a crash.
+  {
+    unique_lock<mutex> guard(lock);
+    for (;;) {
+      if (fd < 0 || failed) return RC_FILE_WRITE_FAILED;
+      if (busy) {
+        done.wait(guard);
+        continue;
+      }
+      bool sync = (mode != SYNC_NONE);
+      if (written == appended && (!sync || synced == appended)) break;
+      if ((rc = writeOut(guard, appended, sync)) < 0) return rc;
+    }
+
+    // nothing was logged since the last checkpoint
+    if (appended == segments.back() && segments.size() == 1) return 0;
+
+    start = appended;
+    if ((rc = startSegment(start)) < 0) return rc;
+    names.swap(files);
+  }
+
+  // every page written before start is either dirty in the pool or
+  // written to its file. write back the dirty ones in pid order. pages
+  // written in the meantime are logged in the new segment anyway.
+  {
+    std::lock_guard<mutex> guard(openLock);
+    for (std::set<PageFile*>::iterator it = openFiles.begin(); it != openFiles.end(); ++it) {
+      if ((rc = (*it)->writeBack()) < 0) break;
+    }
+  }
+
+  // make the pages durable, including those of the files closed since
+  if (rc == 0) {
+    for (std::set<string>::iterator it = names.begin(); it != names.end(); ++it) {
+      if ((tmp = syncFile(*it)) < 0) rc = tmp;
+    }
+  }
+
+  // on failure, the old segments stay until a checkpoint succeeds
+  if (rc < 0) {
+    unique_lock<mutex> guard(lock);
+    files.insert(names.begin(), names.end());
+    return rc;
+  }
+
+  removeSegments(start);
+  return 0;
+}
+
+void WriteAheadLog::attach(PageFile* file)
+{
+  std::lock_guard<mutex> guard(openLock);
+  openFiles.insert(file);
+}
+
+void WriteAheadLog::detach(PageFile* file)
+{
+  std::lock_guard<mutex> guard(openLock);
+  openFiles.erase(file);
+}
+
+string WriteAheadLog::segmentName(long long lsn) const
+{
+  char suffix[32];
+  snprintf(suffix, sizeof(suffix), ".%020lld", lsn);
+  return filename + suffix;
+}
+
+RC WriteAheadLog::startSegment(long long lsn)
+{
+  string name = segmentName(lsn);
+  int nfd = ::open(name.c_str(), O_RDWR|O_CREAT|O_TRUNC, 0644);
+  if (nfd < 0) return RC_FILE_OPEN_FAILED;
+
+  // the segment must be found after a crash, along with its records
+  if (syncDirectory(filename) < 0) {
+    ::close(nfd);
+    ::unlink(name.c_str());
+    return RC_FILE_WRITE_FAILED;
+  }
+
+  if (fd >= 0) ::close(fd);
+  fd = nfd;
+  segments.push_back(lsn);
+  return 0;
+}
+
+void WriteAheadLog::removeSegments(long long lsn)
+{
+  vector<long long> old;
+  {
+    unique_lock<mutex> guard(lock);
+    while (!segments.empty() && segments.front() < lsn) {
+      old.push_back(segments.front());
+      segments.erase(segments.begin());
+    }
+  }
+
+  // the oldest segment goes first. a crash in between leaves the newer
+  // records, whose replay still gives the right pages.
+  for (unsigned i = 0; i < old.size(); i++) ::unlink(segmentName(old[i]).c_str());
+  if (!old.empty()) syncDirectory(filename);
+}
+
+void WriteAheadLog::runSyncer()
+{
+  unique_lock<mutex> guard(lock);
+  while (!stopping) {
+    done.wait_for(guard, std::chrono::milliseconds((int) SYNC_INTERVAL));
+    if (!stopping && !failed && written > synced) writeOut(guard, written, true);
+  }
+}
+
+void WriteAheadLog::runCheckpointer()
+{
+  unique_lock<mutex> guard(lock);
+  while (!stopping) {
+    std::chrono::steady_clock::time_point next =
+      std::chrono::steady_clock::now() + std::chrono::milliseconds(interval);
+    while (!stopping && done.wait_until(guard, next) == std::cv_status::no_timeout);
+    if (stopping) break;
+
+    // a failed checkpoint is tried again at the next interval
+    guard.unlock();
+    checkpoint();
+    guard.lock();
+  }
+}
+
+RC WriteAheadLog::recover()
+{
+  RC rc = 0;
+  std::map<string, PageFile*> opened;
+  vector<long long> lsns;
+  vector<char> record;
+
+  if ((rc = listSegments(filename, lsns)) < 0) return rc;
+
+  // replay the intact records of the segments in their order. a record
+  // torn by the crash ends the log, and so does a missing segment.
+  long long lsn = lsns.empty() ? 0 : lsns[0];
+  bool intact = true;
+  for (unsigned i = 0; i < lsns.size() && intact && rc == 0 && lsns[i] == lsn; i++) {
+    int sfd = ::open(segmentName(lsns[i]).c_str(), O_RDONLY);
+    if (sfd < 0) { rc = RC_FILE_OPEN_FAILED; break; }
+
+    off_t offset = 0;
+    for (;;) {
+      LogRecord header;
+      ssize_t n = ::pread(sfd, &header, sizeof(header), offset);
+      if (n == 0) break;
+      if (n != sizeof(header) || header.magic != RECORD_MAGIC || header.nameLength <= 0 || header.pid < 0 ||
+          header.pageSize < PageFile::MIN_PAGE_SIZE || header.pageSize > PageFile::MAX_PAGE_SIZE) {
+        intact = false;
+        break;
+      }
+
+      size_t size = sizeof(header) + header.nameLength + header.pageSize;
+      record.resize(size);
+      if (::pread(sfd, &record[0], size, offset) != (ssize_t) size) { intact = false; break; }
+      seal(&record[0], size);
+      if (memcmp(&record[offsetof(LogRecord, checksum)], &header.checksum, sizeof(header.checksum)) ||
+          header.lsn != lsn + (long long) size) {
+        intact = false;
+        break;
+      }
+
+      string name(&record[sizeof(header)], header.nameLength);
+      PageFile*& pf = opened[name];
+      if (pf == NULL) {
+        pf = new PageFile;
+        if ((rc = pf->open(name, 'w', header.pageSize)) < 0) break;
+      }
+      if (pf->getPageSize() != header.pageSize) { rc = RC_INVALID_FILE_FORMAT; break; }
+      if ((rc = pf->write(header.pid, &record[sizeof(header) + header.nameLength])) < 0) break;
+
+      offset += size;
+      lsn += size;
+    }
+    ::close(sfd);
+  }
+
+  // write the replayed pages back and make them durable
+  RC tmp;
+  for (std::map<string, PageFile*>::iterator it = opened.begin(); it != opened.end(); ++it) {
+    if ((tmp = it->second->close()) < 0 && rc == 0) rc = tmp;
+    if ((tmp = syncFile(it->first)) < 0 && rc == 0) rc = tmp;
+    delete it->second;
+  }
+  if (rc < 0) return rc;
+
+  // the log is fully applied
+  segments = lsns;
+  removeSegments(LLONG_MAX);
+  return 0;
+}
@@ -0,0 +1,196 @@
+/*
+ * Copyright (C) 2008 by The Regents of the University of California
+ * Redistribution of this file is permitted under the terms of the GNU
+ * Public License (GPL).
+ *
+ * @date 3/24/2008
+ */
+
+#ifndef WRITEAHEADLOG_H
+#define WRITEAHEADLOG_H
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "Bruinbase.h"
+
+class PageFile;
+
+/**
+ * A redo log of page images that sits under PageFile.
+ * Every page written through a PageFile is appended to the log first,
+ * and a dirty page reaches its file only after its log record is on disk.
+ * After a crash, the log is replayed into the files when it is opened.
+ *
+ * Records are collected in memory and written with one sequential write.
+ * A commit waits until the records appended so far are durable. Commits
+ * that arrive while another one is syncing the log are covered by the
+ * next sync together (group commit), so many page changes share one
+ * fsync. A page written again before its record leaves memory only
+ * updates that record.
+ *
+ * The log is a series of segment files named <filename>.<LSN>, each
+ * holding the records from that LSN on. A background thread takes a
+ * fuzzy checkpoint every checkpoint interval: it starts a new segment,
+ * writes the dirty pages of all open files back in pid order while
+ * readers and writers go on, syncs the files, and deletes the older
+ * segments. Only the records since the start of the last finished
+ * checkpoint are replayed after a crash, so the restart time is bounded
+ * by the amount of writes in about two checkpoint intervals.
+ *
+ * A log sequence number (LSN) is the log offset right after a record,
+ * counted over all segments. All functions are safe to call from many
+ * threads.
+ */
+class WriteAheadLog {
+ public:
+  /**
+   * when a commit makes the log durable
+   */
+  enum SyncMode {
+    SYNC_NONE,    // never fsync. a commit hands the log to the OS, which
+                  // survives a crash of the process but not of the machine
+    SYNC_COMMIT,  // a commit waits for the fsync of the log
+    SYNC_DELAYED  // a commit returns once the log is written. a background
+                  // thread fsyncs it every SYNC_INTERVAL ms, so a machine
+                  // crash loses at most the commits of the last interval
+  };
+
+  static const int SYNC_INTERVAL = 50;           // ms between syncs in SYNC_DELAYED
+  static const int CHECKPOINT_INTERVAL = 5000;   // ms between checkpoints by default
+  static const size_t BUFFER_SIZE = 1024 * 1024; // records kept in memory before a write
+
+  WriteAheadLog();
+  ~WriteAheadLog();
+
+  /**
+   * open the log, creating it if needed. the records left by a crash
+   * are replayed into their files first, and the log is emptied.
+   * @param filename[IN] the name of the log. the segments are named after it
+   * @param mode[IN] the sync mode
+   * @param checkpointInterval[IN] ms between checkpoints. 0 turns the
+   *   background checkpoints off
+   * @return error code. 0 if no error
+   */
+  RC open(const std::string& filename, SyncMode mode,
+          int checkpointInterval = CHECKPOINT_INTERVAL);
+
+  /**
+   * make the log durable and close it. the files written through the
+   * log must be closed before, so that their pages are written back.
+   * they are synced, and the log is emptied.
+   * @return error code. 0 if no error
+   */
+  RC close();
+
+  /**
+   * append the new image of a page to the log.
+   * @param file[IN] the PageFile writing the page. identifies the page in memory
+   * @param filename[IN] the name of the file, to find it at recovery
+   * @param pid[IN] the page written
+   * @param page[IN] the new content of the page
+   * @param pageSize[IN] the size of the page
+   * @param lsn[OUT] the LSN of the record
+   * @return error code. 0 if no error
+   */
+  RC append(const void* file, const std::string& filename, int pid,
+            const void* page, int pageSize, long long& lsn);
+
+  /**
+   * make sure the log is on disk up to an LSN, before a page with that
+   * LSN is written to its file. in SYNC_NONE the log is only written.
+   * @param lsn[IN] the LSN that must be on disk
+   * @return error code. 0 if no error
+   */
+  RC flush(long long lsn);
+
+  /**
+   * make all records appended so far durable, as far as the sync mode
+   * promises.
+   * @return error code. 0 if no error
+   */
+  RC commit();
+
+  /**
+   * take a checkpoint: write the dirty pages of all files logged so far
+   * back to the disk and drop the log records they no longer need.
+   * called by the background thread, but may be called at any time.
+   * @return error code. 0 if no error
+   */
+  RC checkpoint();
+
+  /**
+   * register a file opened for writing, so that checkpoints write back
+   * its pages. called by PageFile::open().
+   * @param file[IN] the file
+   */
+  void attach(PageFile* file);
+
+  /**
+   * unregister a file before it is closed. waits for a running
+   * checkpoint to finish with the file. called by PageFile::close().
+   * @param file[IN] the file
+   */
+  void detach(PageFile* file);
+
+  /**
+   * @return the sync mode of the log
+   */
+  SyncMode getSyncMode() const { return mode; }
+
+  /**
+   * parse the name of a sync mode.
+   * @param name[IN] "none", "commit" or "delayed"
+   * @param mode[OUT] the sync mode
+   * @return true if the name is valid
+   */
+  static bool parseSyncMode(const std::string& name, SyncMode& mode);
+
+ private:
+  std::string filename; // the name of the log
+  int       fd;         // the current segment. -1 if closed
+  SyncMode  mode;
+  int       interval;   // ms between checkpoints. 0 if off
+
+  std::mutex lock;               // protects the members below
+  std::condition_variable done;  // signaled when a write or sync finishes
+  std::vector<char> buffer;      // records not yet written
+  std::map<std::pair<const void*, int>, size_t> pending; // record of each page in buffer
+  long long appended;  // the LSN at the end of buffer
+  long long written;   // the log is written up to this LSN
+  long long synced;    // the log is durable up to this LSN
+  bool      busy;      // true while a thread writes or syncs the log
+  bool      failed;    // true after a failed write. the log is unusable then
+  bool      stopping;  // tells the background threads to exit
+  std::vector<long long> segments; // the first LSN of each segment. the last
+                                   // one is the current segment
+  std::set<std::string> files;   // the files with records since the last
+                                 // checkpoint started
+
+  std::mutex openLock;           // protects openFiles. held by a checkpoint
+                                 // while it writes back the pages
+  std::set<PageFile*> openFiles; // the files open for writing
+  std::mutex checkpointLock;     // one checkpoint at a time
+
+  std::thread syncer;       // the background sync thread of SYNC_DELAYED
+  std::thread checkpointer; // the background checkpoint thread
+
+  RC   writeOut(std::unique_lock<std::mutex>& guard, long long lsn, bool sync);
+  RC   startSegment(long long lsn);
+  void removeSegments(long long lsn);
+  std::string segmentName(long long lsn) const;
+  void runSyncer();
+  void runCheckpointer();
+  RC   recover();
+
+  // the log owns its file and thread, so it is not copyable
+  WriteAheadLog(const WriteAheadLog&);
+  WriteAheadLog& operator=(const WriteAheadLog&);
+};
+
+#endif // WRITEAHEADLOG_H
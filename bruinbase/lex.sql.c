@@ -570,7 +570,24 @@ char* strlower(char* s)
         }
 	return s;
 }
-#line 574 "lex.sql.c"
+
+/* keywords that are matched by the identifier rule and then looked up,
+   in all upper or all lower case like the keywords below */
+static const struct { const char* name; int token; } keywords[] = {
+	{ "SHOW", SHOW }, { "show", SHOW },
+	{ "STATS", STATS }, { "stats", STATS },
+	{ "RESET", RESET }, { "reset", RESET },
+	{ "CLUSTERED", CLUSTERED }, { "clustered", CLUSTERED },
+};
+
+static int keyword(const char* s)
+{
+	for (unsigned i = 0; i < sizeof(keywords) / sizeof(keywords[0]); i++) {
+		if (strcmp(s, keywords[i].name) == 0) return keywords[i].token;
+	}
+	return 0;
+}
+#line 591 "lex.sql.c"
 
 #define INITIAL 0
 
@@ -757,10 +774,10 @@ YY_DECL
 	register char *yy_cp, *yy_bp;
 	register int yy_act;
     
-#line 17 "SqlParser.l"
+#line 34 "SqlParser.l"
 
 
-#line 764 "lex.sql.c"
+#line 781 "lex.sql.c"
 
 	if ( !(yy_init) )
 		{
@@ -845,137 +862,137 @@ do_action:	/* This label is used only to access EOF actions. */
 
 case 1:
 YY_RULE_SETUP
-#line 19 "SqlParser.l"
+#line 36 "SqlParser.l"
 return SELECT;
 	YY_BREAK
 case 2:
 YY_RULE_SETUP
-#line 20 "SqlParser.l"
+#line 37 "SqlParser.l"
 return FROM;
 	YY_BREAK
 case 3:
 YY_RULE_SETUP
-#line 21 "SqlParser.l"
+#line 38 "SqlParser.l"
 return WHERE;
 	YY_BREAK
 case 4:
 YY_RULE_SETUP
-#line 22 "SqlParser.l"
+#line 39 "SqlParser.l"
 return LOAD;
 	YY_BREAK
 case 5:
 YY_RULE_SETUP
-#line 23 "SqlParser.l"
+#line 40 "SqlParser.l"
 return WITH;
 	YY_BREAK
 case 6:
 YY_RULE_SETUP
-#line 24 "SqlParser.l"
+#line 41 "SqlParser.l"
 return INDEX;
 	YY_BREAK
 case 7:
 YY_RULE_SETUP
-#line 25 "SqlParser.l"
+#line 42 "SqlParser.l"
 return QUIT;
 	YY_BREAK
 case 8:
 YY_RULE_SETUP
-#line 26 "SqlParser.l"
+#line 43 "SqlParser.l"
 return QUIT;
 	YY_BREAK
 case 9:
 YY_RULE_SETUP
-#line 27 "SqlParser.l"
+#line 44 "SqlParser.l"
 return COUNT;
 	YY_BREAK
 case 10:
 YY_RULE_SETUP
-#line 29 "SqlParser.l"
+#line 46 "SqlParser.l"
 return AND;
 	YY_BREAK
 case 11:
 YY_RULE_SETUP
-#line 30 "SqlParser.l"
+#line 47 "SqlParser.l"
 return OR;
 	YY_BREAK
 case 12:
 YY_RULE_SETUP
-#line 31 "SqlParser.l"
+#line 48 "SqlParser.l"
 return EQUAL;
 	YY_BREAK
 case 13:
 YY_RULE_SETUP
-#line 32 "SqlParser.l"
+#line 49 "SqlParser.l"
 return NEQUAL;
 	YY_BREAK
 case 14:
 YY_RULE_SETUP
-#line 33 "SqlParser.l"
+#line 50 "SqlParser.l"
 return GREATER;
 	YY_BREAK
 case 15:
 YY_RULE_SETUP
-#line 34 "SqlParser.l"
+#line 51 "SqlParser.l"
 return LESS;
 	YY_BREAK
 case 16:
 YY_RULE_SETUP
-#line 35 "SqlParser.l"
+#line 52 "SqlParser.l"
 return GREATEREQUAL;
 	YY_BREAK
 case 17:
 YY_RULE_SETUP
-#line 36 "SqlParser.l"
+#line 53 "SqlParser.l"
 return LESSEQUAL;
 	YY_BREAK
 case 18:
 YY_RULE_SETUP
-#line 38 "SqlParser.l"
+#line 55 "SqlParser.l"
 sqllval.string = strdup(sqltext); return INTEGER;
 	YY_BREAK
 case 19:
 /* rule 19 can match eol */
 YY_RULE_SETUP
-#line 39 "SqlParser.l"
+#line 56 "SqlParser.l"
 sqllval.string = strdup(sqltext+1); sqllval.string[sqlleng-2] = 0; return STRING;
 	YY_BREAK
 case 20:
 YY_RULE_SETUP
-#line 40 "SqlParser.l"
-sqllval.string = strlower(strdup(sqltext)); return ID;
+#line 57 "SqlParser.l"
+if (int t = keyword(sqltext)) return t; sqllval.string = strlower(strdup(sqltext)); return ID;
 	YY_BREAK
 case 21:
 YY_RULE_SETUP
-#line 41 "SqlParser.l"
+#line 58 "SqlParser.l"
 return COMMA;
 	YY_BREAK
 case 22:
 YY_RULE_SETUP
-#line 42 "SqlParser.l"
+#line 59 "SqlParser.l"
 return STAR;
 	YY_BREAK
 case 23:
 /* rule 23 can match eol */
 YY_RULE_SETUP
-#line 43 "SqlParser.l"
+#line 60 "SqlParser.l"
 return LF;
 	YY_BREAK
 case 24:
 YY_RULE_SETUP
-#line 44 "SqlParser.l"
+#line 61 "SqlParser.l"
 /* ignore semicolon */
 	YY_BREAK
 case 25:
 YY_RULE_SETUP
-#line 45 "SqlParser.l"
+#line 62 "SqlParser.l"
 /* ignore white space */
 	YY_BREAK
 case 26:
 YY_RULE_SETUP
-#line 47 "SqlParser.l"
+#line 64 "SqlParser.l"
 ECHO;
 	YY_BREAK
-#line 979 "lex.sql.c"
+#line 996 "lex.sql.c"
 case YY_STATE_EOF(INITIAL):
 	yyterminate();
 
@@ -1973,7 +1990,7 @@ void sqlfree (void * ptr )
 
 #define YYTABLES_NAME "yytables"
 
-#line 47 "SqlParser.l"
+#line 64 "SqlParser.l"
 
 
 
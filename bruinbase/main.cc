@@ -9,12 +9,73 @@
  
 #include "Bruinbase.h"
 #include "SqlEngine.h"
+#include "PageFile.h"
+#include "RecordFile.h"
+#include "WriteAheadLog.h"
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
 
-int main()
+// the write-ahead log in the current directory, next to the tables.
+// its segments are named bruinbase.log.<LSN>
+static const char* LOG_FILE = "bruinbase.log";
+
+int main(int argc, char* argv[])
 {
+  // "-c <MB>" sets the size of the buffer pool,
+  // "-p <KB>" sets the page size of newly created files,
+  // "-z" compresses newly created table files,
+  // "-f <format>" sets the page format of newly created table files,
+  // "-l <mode>" logs all page writes with the given sync mode,
+  // "-k <seconds>" sets the interval between checkpoints of the log, and
+  // "-m" lets queries read the files through memory mappings
+  WriteAheadLog log;
+  WriteAheadLog::SyncMode syncMode;
+  RecordFile::Format format;
+  bool logging = false;
+  int checkpointInterval = WriteAheadLog::CHECKPOINT_INTERVAL;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+      PageFile::setCacheSize((size_t) atol(argv[++i]) * 1024 * 1024);
+    } else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc &&
+               PageFile::setDefaultPageSize(atoi(argv[i + 1]) * 1024) == 0) {
+      i++;
+    } else if (strcmp(argv[i], "-z") == 0) {
+      RecordFile::setCompression(true);
+    } else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc &&
+               RecordFile::parseFormat(argv[i + 1], format)) {
+      RecordFile::setFormat(format);
+      i++;
+    } else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc &&
+               WriteAheadLog::parseSyncMode(argv[i + 1], syncMode)) {
+      logging = true;
+      i++;
+    } else if (strcmp(argv[i], "-k") == 0 && i + 1 < argc) {
+      checkpointInterval = atoi(argv[++i]) * 1000;
+    } else if (strcmp(argv[i], "-m") == 0) {
+      SqlEngine::setMappedReads(true);
+    } else {
+      fprintf(stderr, "usage: %s [-c cache_size_in_MB] [-p page_size_in_KB] [-z] [-f fixed|slotted|pax] [-l none|commit|delayed] [-k checkpoint_interval_in_sec] [-m]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  // replay the log left by a crash before any file is opened
+  if (logging) {
+    if (log.open(LOG_FILE, syncMode, checkpointInterval) < 0) {
+      fprintf(stderr, "cannot open the log %s\n", LOG_FILE);
+      return 1;
+    }
+    PageFile::setLog(&log);
+  }
+
   // run the SQL engine taking user commands from standard input (console).
   SqlEngine::run(stdin);
 
+  if (logging) {
+    PageFile::setLog(NULL);
+    log.close();
+  }
+
   return 0;
 }
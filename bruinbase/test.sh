@@ -7,4 +7,57 @@ rm -f large.tbl large.idx
 rm -f xlarge.tbl xlarge.idx
 
 ./bruinbase < test.sql
+echo
 
+# the checks below print one line each. the script fails if any of
+# them does not hold.
+status=0
+check() {
+  if [ "$2" = "$3" ]; then
+    echo "ok: $1"
+  else
+    echo "FAILED: $1"
+    echo "  got:      $2"
+    echo "  expected: $3"
+    status=1
+  fi
+}
+
+# a table and an index created with 4KB pages keep them when they are
+# opened again, and answer like the same table with 1KB pages
+rm -f psize.tbl psize.idx psize.zm psize.bf
+rm -f pdflt.tbl pdflt.idx pdflt.zm pdflt.bf
+echo "LOAD psize FROM 'movie.del' WITH INDEX" | ./bruinbase -p 4 > /dev/null 2>&1
+echo "LOAD pdflt FROM 'movie.del' WITH INDEX" | ./bruinbase > /dev/null 2>&1
+check "4KB page size in the table header" "$(od -An -t d4 -j 8 -N 4 psize.tbl | tr -d ' ')" 4096
+check "4KB page size in the index header" "$(od -An -t d4 -j 8 -N 4 psize.idx | tr -d ' ')" 4096
+check "4KB pages after reopening" \
+  "$(printf 'SELECT COUNT(*) FROM psize\nSELECT * FROM psize WHERE key > 4600 AND key < 4610\n' | ./bruinbase 2> /dev/null)" \
+  "$(printf 'SELECT COUNT(*) FROM pdflt\nSELECT * FROM pdflt WHERE key > 4600 AND key < 4610\n' | ./bruinbase 2> /dev/null)"
+rm -f psize.tbl psize.idx psize.zm psize.bf
+rm -f pdflt.tbl pdflt.idx pdflt.zm pdflt.bf
+
+# a load streams the table pages through a 1MB pool once, while every
+# insert uses the upper index pages again. under 2Q the table pages
+# are evicted, but the index pages are never read back.
+rm -f twoq.tbl twoq.idx twoq.zm twoq.bf
+stats=$(printf "LOAD twoq FROM 'xlarge.del' WITH INDEX\nSHOW STATS\n" | ./bruinbase -c 1 2> /dev/null)
+check "table pages evicted by a load" \
+  "$(echo "$stats" | awk '$1 == "twoq.tbl" && $2 == "record" { print ($6 > 0) }')" 1
+check "index pages missed during a load" \
+  "$(echo "$stats" | awk '$1 == "twoq.idx" && $2 != "meta" { m += $4 } END { print m + 0 }')" 0
+rm -f twoq.tbl twoq.idx twoq.zm twoq.bf
+
+# a table reaching past 2GB. a copy of its first page is put right
+# after 2GB of 64KB pages. the hole before it takes no disk space.
+# the zone map and the bloom filter describe the loaded pages only.
+rm -f huge.tbl huge.zm huge.bf
+echo "LOAD huge FROM 'small.del'" | ./bruinbase -p 64 > /dev/null 2>&1
+rm -f huge.zm huge.bf
+dd if=huge.tbl of=huge.tbl bs=65536 skip=1 seek=32769 count=1 conv=notrunc 2> /dev/null
+check "records past 2GB" \
+  "$(printf 'SELECT COUNT(*) FROM huge\nSELECT key FROM huge WHERE key = 272\n' | ./bruinbase 2> /dev/null)" \
+  "$(printf 'Bruinbase> 100\nBruinbase> 272\n272\nBruinbase> ')"
+rm -f huge.tbl huge.zm huge.bf
+
+exit $status